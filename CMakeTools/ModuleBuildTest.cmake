@@ -0,0 +1,42 @@
+# Build a test program, linking it with Crimild libraries, and register it with CTest
+# Arguments:
+# CRIMILD_TEST_NAME: (Required) Name for the test project
+
+MESSAGE( "   " ${CRIMILD_TEST_NAME} )
+
+FILE( GLOB_RECURSE CRIMILD_TEST_HEADER_FILES "${CRIMILD_GL_SOURCE_DIR}/tests/${CRIMILD_TEST_NAME}/*.hpp" )
+FILE( GLOB_RECURSE CRIMILD_TEST_SOURCE_FILES "${CRIMILD_GL_SOURCE_DIR}/tests/${CRIMILD_TEST_NAME}/*.cpp" )
+
+SET( CRIMILD_TEST_DEPENDENCIES 
+	crimild
+	crimild-gl )
+
+SET( CRIMILD_TESTS_LINK_LIBRARIES 
+	crimild
+	crimild-gl )
+
+INCLUDE_DIRECTORIES(
+	${CRIMILD_SOURCE_DIR}/src 
+	${CRIMILD_GL_SOURCE_DIR}/src )
+
+LINK_DIRECTORIES(
+	${CRIMILD_SOURCE_DIR}/lib
+	${CRIMILD_GL_SOURCE_DIR}/lib )
+
+IF ( APPLE )
+	SET( CRIMILD_TESTS_LINK_LIBRARIES 
+		${CRIMILD_TESTS_LINK_LIBRARIES} 
+		"-framework Cocoa -framework OpenGL -framework IOKit" )
+ENDIF ( APPLE )
+
+ADD_EXECUTABLE( ${CRIMILD_TEST_NAME}
+	${CRIMILD_TEST_SOURCE_FILES}
+	${CRIMILD_TEST_HEADER_FILES} )
+TARGET_LINK_LIBRARIES( ${CRIMILD_TEST_NAME} ${CRIMILD_TESTS_LINK_LIBRARIES} )
+ADD_DEPENDENCIES( ${CRIMILD_TEST_NAME} ${CRIMILD_TEST_DEPENDENCIES} )
+
+ADD_TEST( ${CRIMILD_TEST_NAME} ${CRIMILD_TEST_NAME} )
+
+# tests needing resources that are not available, like a GL context, 
+# exit with this code so they are reported as skipped instead of passed
+SET_TESTS_PROPERTIES( ${CRIMILD_TEST_NAME} PROPERTIES SKIP_RETURN_CODE 77 )
@@ -0,0 +1,36 @@
+# Build a command line tool, linking it with Crimild libraries
+# Arguments:
+# CRIMILD_TOOL_NAME: (Required) Name for the tool project
+
+MESSAGE( "   " ${CRIMILD_TOOL_NAME} )
+
+FILE( GLOB_RECURSE CRIMILD_TOOL_HEADER_FILES "${CRIMILD_GL_SOURCE_DIR}/tools/${CRIMILD_TOOL_NAME}/*.hpp" )
+FILE( GLOB_RECURSE CRIMILD_TOOL_SOURCE_FILES "${CRIMILD_GL_SOURCE_DIR}/tools/${CRIMILD_TOOL_NAME}/*.cpp" )
+
+SET( CRIMILD_TOOL_DEPENDENCIES 
+	crimild
+	crimild-gl )
+
+SET( CRIMILD_TOOLS_LINK_LIBRARIES 
+	crimild
+	crimild-gl )
+
+INCLUDE_DIRECTORIES(
+	${CRIMILD_SOURCE_DIR}/src 
+	${CRIMILD_GL_SOURCE_DIR}/src )
+
+LINK_DIRECTORIES(
+	${CRIMILD_SOURCE_DIR}/lib
+	${CRIMILD_GL_SOURCE_DIR}/lib )
+
+IF ( APPLE )
+	SET( CRIMILD_TOOLS_LINK_LIBRARIES 
+		${CRIMILD_TOOLS_LINK_LIBRARIES} 
+		"-framework Cocoa -framework OpenGL -framework IOKit" )
+ENDIF ( APPLE )
+
+ADD_EXECUTABLE( ${CRIMILD_TOOL_NAME}
+	${CRIMILD_TOOL_SOURCE_FILES}
+	${CRIMILD_TOOL_HEADER_FILES} )
+TARGET_LINK_LIBRARIES( ${CRIMILD_TOOL_NAME} ${CRIMILD_TOOLS_LINK_LIBRARIES} )
+ADD_DEPENDENCIES( ${CRIMILD_TOOL_NAME} ${CRIMILD_TOOL_DEPENDENCIES} )
@@ -70,9 +70,8 @@ public:
 	}
 };
 
-NodePtr makeSphere( float x, float y, float z )
+NodePtr makeSphere( PrimitivePtr primitive, float x, float y, float z )
 {
-	PrimitivePtr primitive( new ParametricSpherePrimitive( Primitive::Type::TRIANGLES, 1.0f ) );
 	GeometryPtr geometry( new Geometry() );
 	geometry->attachPrimitive( primitive );
 
@@ -95,15 +94,18 @@ int main( int argc, char **argv )
 
 	GroupPtr scene( new Group() );
 
+	// all spheres share the same primitive so they can be drawn with a single instanced call
+	PrimitivePtr sphere( new ParametricSpherePrimitive( Primitive::Type::TRIANGLES, 1.0f ) );
 	for ( float x = -5.0f; x <= 5.0f; x++ ) {
 		for ( float y = -3.0f; y <= 3.0f; y++ ) {
-			scene->attachNode( makeSphere( x * 3.0f, y * 3.0f, 0.0f ) );
+			scene->attachNode( makeSphere( sphere, x * 3.0f, y * 3.0f, 0.0f ) );
 		}
 	}
 
 	CameraPtr camera( new Camera() );
 	NodeComponentPtr pickingComponent( new PickingComponent() );
 	camera->attachComponent( pickingComponent );
+	camera->setRenderPass( GL3::SortedRenderPassPtr( new GL3::SortedRenderPass() ) );
 	camera->local().setTranslate( 10.0f, 15.0f, 50.0f );
 	camera->local().setRotate( Vector3f( -1.0f, 0.5f, 0.0f ).getNormalized(), 0.1 * Numericf::PI );
 	scene->attachNode( camera );
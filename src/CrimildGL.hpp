@@ -28,13 +28,37 @@
 #ifndef CRIMILD_GL_
 #define CRIMILD_GL_
 
+#include "Rendering/GL3/BlockCompressor.hpp"
+#include "Rendering/GL3/BufferArena.hpp"
+#include "Rendering/GL3/BufferPool.hpp"
+#include "Rendering/GL3/CompressedImage.hpp"
+#include "Rendering/GL3/DirtyRangeSet.hpp"
+#include "Rendering/GL3/DynamicVertexBufferObject.hpp"
+#include "Rendering/GL3/HandleTable.hpp"
 #include "Rendering/GL3/IndexBufferObjectCatalog.hpp"
+#include "Rendering/GL3/InstanceBuffer.hpp"
+#include "Rendering/GL3/MeshOptimizer.hpp"
 #include "Rendering/GL3/Renderer.hpp"
+#include "Rendering/GL3/MipChain.hpp"
 #include "Rendering/GL3/OffscreenRenderPass.hpp"
+#include "Rendering/GL3/PackedVertexLayout.hpp"
+#include "Rendering/GL3/RenderQueue.hpp"
+#include "Rendering/GL3/SampledTexture.hpp"
+#include "Rendering/GL3/SamplerState.hpp"
 #include "Rendering/GL3/ShaderProgramCatalog.hpp"
+#include "Rendering/GL3/SortedRenderPass.hpp"
+#include "Rendering/GL3/StateCache.hpp"
+#include "Rendering/GL3/StaticBatchComponent.hpp"
+#include "Rendering/GL3/StaticBatcher.hpp"
+#include "Rendering/GL3/Stripifier.hpp"
+#include "Rendering/GL3/StreamBuffer.hpp"
+#include "Rendering/GL3/SubMeshPrimitive.hpp"
 #include "Rendering/GL3/TextureCatalog.hpp"
+#include "Rendering/GL3/UniformBuffer.hpp"
+#include "Rendering/GL3/UniformCache.hpp"
 #include "Rendering/GL3/Utils.hpp"
 #include "Rendering/GL3/VertexBufferObjectCatalog.hpp"
+#include "Rendering/GL3/VertexLayout.hpp"
 
 #include "Rendering/GL3/Library/SepiaToneShaderProgram.hpp"
 
@@ -42,8 +66,12 @@
 #include "Rendering/GL3/Library/FlatShaderProgram.hpp"
 #include "Rendering/GL3/Library/GouraudMaterial.hpp"
 #include "Rendering/GL3/Library/GouraudShaderProgram.hpp"
+#include "Rendering/GL3/Library/InstancedFlatShaderProgram.hpp"
+#include "Rendering/GL3/Library/InstancedPhongShaderProgram.hpp"
+#include "Rendering/GL3/Library/InstancedTextureArrayShaderProgram.hpp"
 #include "Rendering/GL3/Library/PhongMaterial.hpp"
 #include "Rendering/GL3/Library/PhongShaderProgram.hpp"
+#include "Rendering/GL3/Library/TextureArrayShaderProgram.hpp"
 
 #include "Simulation/GLSimulation.hpp"
 
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BlockCompressor.hpp"
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace Crimild;
+
+namespace {
+
+	const unsigned int BLOCK_TEXELS = 16;
+
+	unsigned short packColor( const float *color )
+	{
+		int r = std::max( 0, std::min( 31, ( int )( color[ 0 ] * 31.0f / 255.0f + 0.5f ) ) );
+		int g = std::max( 0, std::min( 63, ( int )( color[ 1 ] * 63.0f / 255.0f + 0.5f ) ) );
+		int b = std::max( 0, std::min( 31, ( int )( color[ 2 ] * 31.0f / 255.0f + 0.5f ) ) );
+		return ( unsigned short )( ( r << 11 ) | ( g << 5 ) | b );
+	}
+
+	void unpackColor( unsigned short packed, int *color )
+	{
+		int r = ( packed >> 11 ) & 0x1F;
+		int g = ( packed >> 5 ) & 0x3F;
+		int b = packed & 0x1F;
+		color[ 0 ] = ( r << 3 ) | ( r >> 2 );
+		color[ 1 ] = ( g << 2 ) | ( g >> 4 );
+		color[ 2 ] = ( b << 3 ) | ( b >> 2 );
+	}
+
+	int colorDistance( const unsigned char *a, const int *b )
+	{
+		int dr = a[ 0 ] - b[ 0 ];
+		int dg = a[ 1 ] - b[ 1 ];
+		int db = a[ 2 ] - b[ 2 ];
+		return dr * dr + dg * dg + db * db;
+	}
+
+}
+
+GL3::CompressedImagePtr GL3::BlockCompressor::compress( unsigned int width, unsigned int height, unsigned int bpp, const unsigned char *data, bool mipmaps )
+{
+	bool opaque = true;
+	if ( bpp == 4 ) {
+		for ( unsigned int i = 0; opaque && i < width * height; i++ ) {
+			opaque = data[ i * 4 + 3 ] == 255;
+		}
+	}
+
+	unsigned int format = opaque ? CompressedImage::Format::BC1 : CompressedImage::Format::BC3;
+	CompressedImagePtr image( new CompressedImage( format, width, height ) );
+
+	std::vector< unsigned char > output;
+	if ( mipmaps ) {
+		MipChain chain( width, height, bpp, data );
+		for ( unsigned int level = 0; level < chain.getLevelCount(); level++ ) {
+			encodeLevel( format, chain.getLevelWidth( level ), chain.getLevelHeight( level ), bpp, chain.getLevelData( level ), output );
+			image->addLevel( &output[ 0 ], output.size() );
+		}
+	}
+	else {
+		encodeLevel( format, width, height, bpp, data, output );
+		image->addLevel( &output[ 0 ], output.size() );
+	}
+
+	return image;
+}
+
+void GL3::BlockCompressor::encodeLevel( unsigned int format, unsigned int width, unsigned int height, unsigned int bpp, const unsigned char *data, std::vector< unsigned char > &output )
+{
+	unsigned int blockSize = CompressedImage::getBlockSize( format );
+	unsigned int blocksX = std::max( 1u, ( width + 3 ) / 4 );
+	unsigned int blocksY = std::max( 1u, ( height + 3 ) / 4 );
+	output.resize( blocksX * blocksY * blockSize );
+
+	unsigned char texels[ BLOCK_TEXELS * 4 ];
+	unsigned char *block = &output[ 0 ];
+	for ( unsigned int by = 0; by < blocksY; by++ ) {
+		for ( unsigned int bx = 0; bx < blocksX; bx++ ) {
+			// blocks crossing the image border repeat the last row or column
+			for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+				unsigned int x = std::min( bx * 4 + i % 4, width - 1 );
+				unsigned int y = std::min( by * 4 + i / 4, height - 1 );
+				const unsigned char *src = data + ( y * width + x ) * bpp;
+				texels[ i * 4 + 0 ] = src[ 0 ];
+				texels[ i * 4 + 1 ] = src[ 1 ];
+				texels[ i * 4 + 2 ] = src[ 2 ];
+				texels[ i * 4 + 3 ] = bpp == 4 ? src[ 3 ] : 255;
+			}
+
+			if ( format == CompressedImage::Format::BC3 ) {
+				encodeBC3( texels, block );
+			}
+			else {
+				encodeBC1( texels, block );
+			}
+
+			block += blockSize;
+		}
+	}
+}
+
+void GL3::BlockCompressor::encodeBC1( const unsigned char *texels, unsigned char *block )
+{
+	encodeColor( texels, block );
+}
+
+void GL3::BlockCompressor::encodeBC3( const unsigned char *texels, unsigned char *block )
+{
+	encodeAlpha( texels, block );
+	encodeColor( texels, block + 8 );
+}
+
+void GL3::BlockCompressor::encodeColor( const unsigned char *texels, unsigned char *block )
+{
+	float mean[ 3 ] = { 0.0f, 0.0f, 0.0f };
+	for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+		for ( unsigned int c = 0; c < 3; c++ ) {
+			mean[ c ] += texels[ i * 4 + c ];
+		}
+	}
+	for ( unsigned int c = 0; c < 3; c++ ) {
+		mean[ c ] /= BLOCK_TEXELS;
+	}
+
+	float covariance[ 6 ] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+		float r = texels[ i * 4 + 0 ] - mean[ 0 ];
+		float g = texels[ i * 4 + 1 ] - mean[ 1 ];
+		float b = texels[ i * 4 + 2 ] - mean[ 2 ];
+		covariance[ 0 ] += r * r;
+		covariance[ 1 ] += r * g;
+		covariance[ 2 ] += r * b;
+		covariance[ 3 ] += g * g;
+		covariance[ 4 ] += g * b;
+		covariance[ 5 ] += b * b;
+	}
+
+	// a few power iterations are enough to find the principal axis
+	float axis[ 3 ] = { 1.0f, 1.0f, 1.0f };
+	for ( unsigned int iteration = 0; iteration < 8; iteration++ ) {
+		float x = covariance[ 0 ] * axis[ 0 ] + covariance[ 1 ] * axis[ 1 ] + covariance[ 2 ] * axis[ 2 ];
+		float y = covariance[ 1 ] * axis[ 0 ] + covariance[ 3 ] * axis[ 1 ] + covariance[ 4 ] * axis[ 2 ];
+		float z = covariance[ 2 ] * axis[ 0 ] + covariance[ 4 ] * axis[ 1 ] + covariance[ 5 ] * axis[ 2 ];
+		float length = std::max( std::max( std::abs( x ), std::abs( y ) ), std::abs( z ) );
+		if ( length == 0.0f ) {
+			break;
+		}
+
+		axis[ 0 ] = x / length;
+		axis[ 1 ] = y / length;
+		axis[ 2 ] = z / length;
+	}
+
+	unsigned int minIndex = 0;
+	unsigned int maxIndex = 0;
+	float minProjection = 0.0f;
+	float maxProjection = 0.0f;
+	for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+		float projection = texels[ i * 4 + 0 ] * axis[ 0 ] + texels[ i * 4 + 1 ] * axis[ 1 ] + texels[ i * 4 + 2 ] * axis[ 2 ];
+		if ( i == 0 || projection < minProjection ) {
+			minProjection = projection;
+			minIndex = i;
+		}
+		if ( i == 0 || projection > maxProjection ) {
+			maxProjection = projection;
+			maxIndex = i;
+		}
+	}
+
+	float maxColor[ 3 ] = { ( float ) texels[ maxIndex * 4 + 0 ], ( float ) texels[ maxIndex * 4 + 1 ], ( float ) texels[ maxIndex * 4 + 2 ] };
+	float minColor[ 3 ] = { ( float ) texels[ minIndex * 4 + 0 ], ( float ) texels[ minIndex * 4 + 1 ], ( float ) texels[ minIndex * 4 + 2 ] };
+	unsigned short color0 = packColor( maxColor );
+	unsigned short color1 = packColor( minColor );
+
+	// the first endpoint must be larger to select the four color mode
+	if ( color0 < color1 ) {
+		std::swap( color0, color1 );
+	}
+
+	unsigned int indices = 0;
+	if ( color0 != color1 ) {
+		int palette[ 4 ][ 3 ];
+		unpackColor( color0, palette[ 0 ] );
+		unpackColor( color1, palette[ 1 ] );
+		for ( unsigned int c = 0; c < 3; c++ ) {
+			palette[ 2 ][ c ] = ( 2 * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3;
+			palette[ 3 ][ c ] = ( palette[ 0 ][ c ] + 2 * palette[ 1 ][ c ] ) / 3;
+		}
+
+		for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+			unsigned int best = 0;
+			int bestDistance = colorDistance( &texels[ i * 4 ], palette[ 0 ] );
+			for ( unsigned int p = 1; p < 4; p++ ) {
+				int distance = colorDistance( &texels[ i * 4 ], palette[ p ] );
+				if ( distance < bestDistance ) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+
+			indices |= best << ( i * 2 );
+		}
+	}
+
+	block[ 0 ] = color0 & 0xFF;
+	block[ 1 ] = color0 >> 8;
+	block[ 2 ] = color1 & 0xFF;
+	block[ 3 ] = color1 >> 8;
+	for ( unsigned int i = 0; i < 4; i++ ) {
+		block[ 4 + i ] = ( indices >> ( i * 8 ) ) & 0xFF;
+	}
+}
+
+void GL3::BlockCompressor::encodeAlpha( const unsigned char *texels, unsigned char *block )
+{
+	unsigned char alpha0 = 0;
+	unsigned char alpha1 = 255;
+	for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+		alpha0 = std::max( alpha0, texels[ i * 4 + 3 ] );
+		alpha1 = std::min( alpha1, texels[ i * 4 + 3 ] );
+	}
+
+	// alpha0 > alpha1 selects eight interpolated values
+	int palette[ 8 ] = { alpha0, alpha1 };
+	for ( unsigned int i = 1; i < 7; i++ ) {
+		palette[ i + 1 ] = ( ( 7 - i ) * alpha0 + i * alpha1 ) / 7;
+	}
+
+	unsigned long long indices = 0;
+	if ( alpha0 != alpha1 ) {
+		for ( unsigned int i = 0; i < BLOCK_TEXELS; i++ ) {
+			unsigned int best = 0;
+			int bestDistance = 256;
+			for ( unsigned int p = 0; p < 8; p++ ) {
+				int distance = std::abs( texels[ i * 4 + 3 ] - palette[ p ] );
+				if ( distance < bestDistance ) {
+					bestDistance = distance;
+					best = p;
+				}
+			}
+
+			indices |= ( unsigned long long ) best << ( i * 3 );
+		}
+	}
+
+	block[ 0 ] = alpha0;
+	block[ 1 ] = alpha1;
+	for ( unsigned int i = 0; i < 6; i++ ) {
+		block[ 2 + i ] = ( indices >> ( i * 8 ) ) & 0xFF;
+	}
+}
+
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_BLOCK_COMPRESSOR_
+#define CRIMILD_GL3_BLOCK_COMPRESSOR_
+
+#include "CompressedImage.hpp"
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Encodes 8-bit RGB and RGBA pixels into BC1 or BC3 blocks
+
+			Meant for offline conversion of source images, not for use 
+			at load time. Endpoints are taken from the extremes of each 
+			block along its principal color axis, which is fast and close 
+			enough for diffuse textures, but does not search for the 
+			best possible endpoints.
+		*/
+		class BlockCompressor {
+		public:
+			/**
+				\brief Compresses an image, optionally with a full mipmap chain
+
+				Images without alpha, or with all texels opaque, are stored 
+				as BC1. Everything else is stored as BC3.
+
+				\param bpp Bytes per pixel, either 3 or 4
+			*/
+			static CompressedImagePtr compress( unsigned int width, unsigned int height, unsigned int bpp, const unsigned char *data, bool mipmaps = true );
+
+			/**
+				\brief Encodes a 4x4 block of RGBA texels into 8 bytes
+			*/
+			static void encodeBC1( const unsigned char *texels, unsigned char *block );
+
+			/**
+				\brief Encodes a 4x4 block of RGBA texels into 16 bytes
+			*/
+			static void encodeBC3( const unsigned char *texels, unsigned char *block );
+
+		private:
+			static void encodeColor( const unsigned char *texels, unsigned char *block );
+			static void encodeAlpha( const unsigned char *texels, unsigned char *block );
+			static void encodeLevel( unsigned int format, unsigned int width, unsigned int height, unsigned int bpp, const unsigned char *data, std::vector< unsigned char > &output );
+		};
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BufferArena.hpp"
+#include "VertexBufferObjectCatalog.hpp"
+#include "StateCache.hpp"
+#include "Utils.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+#include <cstring>
+
+using namespace Crimild;
+
+GL3::BufferArena::BufferArena( const VertexFormat &format )
+	: _format( format ),
+	  _deadVertexCount( 0 ),
+	  _appendsSinceSweep( 0 ),
+	  _dirty( false ),
+	  _vaoId( 0 ),
+	  _vboId( 0 ),
+	  _iboId( 0 )
+{
+
+}
+
+GL3::BufferArena::~BufferArena( void )
+{
+
+}
+
+bool GL3::BufferArena::getRange( Geometry *geometry, PrimitivePtr &primitive, Range &range )
+{
+	VertexBufferObject *vbo = primitive->getVertexBuffer();
+	IndexBufferObject *ibo = primitive->getIndexBuffer();
+	if ( vbo == nullptr || ibo == nullptr || vbo->getVertexFormat() != _format || _format.getPositionComponents() != 3 ) {
+		return false;
+	}
+
+	Matrix4f model = geometry->getWorld().computeModelMatrix();
+	EntryKey key = std::make_pair( geometry, primitive.get() );
+
+	auto it = _entries.find( key );
+	if ( it != _entries.end() ) {
+		PrimitivePtr owner = it->second.primitive.lock();
+		if ( owner == primitive && memcmp( it->second.model.getData(), model.getData(), 16 * sizeof( float ) ) == 0 ) {
+			range = it->second.range;
+			return true;
+		}
+
+		// the address was reused by a different primitive, 
+		// or the geometry moved since its vertices were copied
+		_deadVertexCount += it->second.vertexCount;
+		_entries.erase( it );
+	}
+
+	// sweeping visits every entry, so it only runs once a good share of 
+	// them were added since the last one. That keeps its amortized cost 
+	// per miss constant while bounding the amount of dead entries
+	if ( _appendsSinceSweep * 2 >= _entries.size() ) {
+		sweep();
+	}
+
+	if ( _deadVertexCount > 0 && _deadVertexCount * 2 > _vertices.size() / _format.getVertexSize() ) {
+		compact();
+	}
+
+	Entry &entry = _entries[ key ];
+	entry.world = geometry->getWorld();
+	entry.model = model;
+	append( primitive, entry );
+	range = entry.range;
+	return true;
+}
+
+void GL3::BufferArena::append( PrimitivePtr &primitive, Entry &entry )
+{
+	VertexBufferObject *vbo = primitive->getVertexBuffer();
+	IndexBufferObject *ibo = primitive->getIndexBuffer();
+
+	entry.primitive = primitive;
+	entry.vertexCount = vbo->getVertexCount();
+	entry.range.baseVertex = _vertices.size() / _format.getVertexSize();
+	entry.range.firstIndex = _indices.size();
+	entry.range.indexCount = ibo->getIndexCount();
+
+	unsigned int vertexSize = _format.getVertexSize();
+	const float *vertexData = vbo->getData();
+	_vertices.insert( _vertices.end(), vertexData, vertexData + vbo->getVertexCount() * vertexSize );
+
+	float *dst = &_vertices[ entry.range.baseVertex * vertexSize ];
+	for ( unsigned int i = 0; i < entry.vertexCount; i++ ) {
+		float *vertex = dst + i * vertexSize;
+
+		float *p = vertex + _format.getPositionsOffset();
+		Vector3f position;
+		entry.world.applyToPoint( Vector3f( p[ 0 ], p[ 1 ], p[ 2 ] ), position );
+		p[ 0 ] = position[ 0 ];
+		p[ 1 ] = position[ 1 ];
+		p[ 2 ] = position[ 2 ];
+
+		if ( _format.hasNormals() ) {
+			float *n = vertex + _format.getNormalsOffset();
+			Vector3f normal;
+			entry.world.applyToVector( Vector3f( n[ 0 ], n[ 1 ], n[ 2 ] ), normal );
+			if ( normal.getSquaredMagnitude() > 0.0f ) {
+				normal = normal.getNormalized();
+			}
+			n[ 0 ] = normal[ 0 ];
+			n[ 1 ] = normal[ 1 ];
+			n[ 2 ] = normal[ 2 ];
+		}
+	}
+
+	const unsigned short *indexData = ibo->getData();
+	_indices.insert( _indices.end(), indexData, indexData + ibo->getIndexCount() );
+
+	++_appendsSinceSweep;
+	_dirty = true;
+}
+
+void GL3::BufferArena::sweep( void )
+{
+	for ( auto it = _entries.begin(); it != _entries.end(); ) {
+		if ( it->second.primitive.expired() ) {
+			_deadVertexCount += it->second.vertexCount;
+			it = _entries.erase( it );
+		}
+		else {
+			++it;
+		}
+	}
+
+	_appendsSinceSweep = 0;
+}
+
+void GL3::BufferArena::compact( void )
+{
+	_vertices.clear();
+	_indices.clear();
+	_deadVertexCount = 0;
+	_appendsSinceSweep = 0;
+
+	for ( auto it = _entries.begin(); it != _entries.end(); ) {
+		PrimitivePtr primitive = it->second.primitive.lock();
+		if ( primitive == nullptr ) {
+			it = _entries.erase( it );
+		}
+		else {
+			append( primitive, it->second );
+			++it;
+		}
+	}
+}
+
+void GL3::BufferArena::bind( StateCache *stateCache )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	if ( _vaoId == 0 ) {
+		glGenVertexArrays( 1, &_vaoId );
+		glGenBuffers( 1, &_vboId );
+		glGenBuffers( 1, &_iboId );
+
+		stateCache->bindVertexArray( _vaoId );
+
+		glBindBuffer( GL_ARRAY_BUFFER, _vboId );
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _iboId );
+		VertexBufferObjectCatalog::configureAttributes( _format );
+	}
+	else {
+		stateCache->bindVertexArray( _vaoId );
+	}
+
+	if ( _dirty ) {
+		glBindBuffer( GL_ARRAY_BUFFER, _vboId );
+		glBufferData( GL_ARRAY_BUFFER, _vertices.size() * sizeof( float ), &_vertices[ 0 ], GL_STATIC_DRAW );
+
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _iboId );
+		glBufferData( GL_ELEMENT_ARRAY_BUFFER, _indices.size() * sizeof( unsigned short ), &_indices[ 0 ], GL_STATIC_DRAW );
+
+		_dirty = false;
+	}
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+void GL3::BufferArena::unload( StateCache *stateCache )
+{
+	if ( _vaoId > 0 ) {
+		glDeleteBuffers( 1, &_vboId );
+		glDeleteBuffers( 1, &_iboId );
+		glDeleteVertexArrays( 1, &_vaoId );
+		stateCache->invalidateVertexArray( _vaoId );
+
+		_vaoId = _vboId = _iboId = 0;
+	}
+
+	_dirty = !_vertices.empty();
+}
+
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_BUFFER_ARENA_
+#define CRIMILD_GL3_BUFFER_ARENA_
+
+#include <Crimild.hpp>
+
+#include <map>
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		class StateCache;
+
+		/**
+			\brief Shared vertex and index storage for static primitives
+
+			Primitives with the same vertex format are packed into a single 
+			vertex buffer and a single index buffer behind one vertex array.
+			Indices are kept relative to each primitive and offset with a 
+			base vertex at draw time, so a whole bucket of primitives can 
+			be submitted with glMultiDrawElementsBaseVertex.
+
+			Vertices are copied in world space, with positions and normals 
+			transformed by the geometry drawing them, so primitives of 
+			different geometries can share a submission with an identity 
+			model matrix. A primitive drawn by several geometries gets one 
+			copy for each. Only formats with 3-component positions are 
+			accepted.
+
+			\remarks Primitive data is copied once. Later modifications to
+			the primitive's buffers are not reflected in the arena. A 
+			geometry that moves gets its vertices copied again, so moving 
+			geometries should not be drawn through an arena. Entries for 
+			destroyed primitives are swept as new ones are added, and the 
+			arena compacts itself once dead data outweighs live data.
+		*/
+		class BufferArena {
+		public:
+			struct Range {
+				int baseVertex;
+				unsigned int firstIndex;
+				unsigned int indexCount;
+			};
+
+		public:
+			BufferArena( const VertexFormat &format );
+			virtual ~BufferArena( void );
+
+			const VertexFormat &getVertexFormat( void ) const { return _format; }
+
+			/**
+				\brief Returns the range for a primitive drawn by a geometry, adding it to the arena if needed
+			*/
+			bool getRange( Geometry *geometry, PrimitivePtr &primitive, Range &range );
+
+			/**
+				\brief Uploads pending data and binds the arena's vertex array
+			*/
+			void bind( StateCache *stateCache );
+
+			void unload( StateCache *stateCache );
+
+		private:
+			struct Entry {
+				std::weak_ptr< Primitive > primitive;
+				TransformationImpl world;
+				Matrix4f model;
+				Range range;
+				unsigned int vertexCount;
+			};
+
+			typedef std::pair< Geometry *, Primitive * > EntryKey;
+
+			void append( PrimitivePtr &primitive, Entry &entry );
+			void sweep( void );
+			void compact( void );
+
+			VertexFormat _format;
+			std::vector< float > _vertices;
+			std::vector< unsigned short > _indices;
+			std::map< EntryKey, Entry > _entries;
+			unsigned int _deadVertexCount;
+			unsigned int _appendsSinceSweep;
+			bool _dirty;
+
+			unsigned int _vaoId;
+			unsigned int _vboId;
+			unsigned int _iboId;
+		};
+
+		typedef std::shared_ptr< BufferArena > BufferArenaPtr;
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "BufferPool.hpp"
+#include "Utils.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+using namespace Crimild;
+
+namespace {
+
+	// compacting costs a copy of every live block, so it only 
+	// pays off when space is both underused and fragmented
+	const unsigned int DEFRAGMENT_MIN_FREE_BLOCKS = 16;
+
+}
+
+GL3::BufferPool::BufferPool( unsigned int capacity )
+	: _bufferId( 0 ),
+	  _capacity( capacity ),
+	  _usedSize( 0 )
+{
+	_freeBlocks[ 0 ] = _capacity;
+}
+
+GL3::BufferPool::~BufferPool( void )
+{
+
+}
+
+bool GL3::BufferPool::allocate( unsigned int size, unsigned int alignment, int owner, unsigned int &offset )
+{
+	if ( size == 0 || alignment == 0 ) {
+		return false;
+	}
+
+	for ( auto it = _freeBlocks.begin(); it != _freeBlocks.end(); it++ ) {
+		unsigned int blockOffset = it->first;
+		unsigned int blockSize = it->second;
+		unsigned int aligned = ( ( blockOffset + alignment - 1 ) / alignment ) * alignment;
+		if ( aligned + size > blockOffset + blockSize ) {
+			continue;
+		}
+
+		_freeBlocks.erase( it );
+		if ( aligned > blockOffset ) {
+			_freeBlocks[ blockOffset ] = aligned - blockOffset;
+		}
+		if ( aligned + size < blockOffset + blockSize ) {
+			_freeBlocks[ aligned + size ] = blockOffset + blockSize - aligned - size;
+		}
+
+		Block block;
+		block.size = size;
+		block.alignment = alignment;
+		block.owner = owner;
+		_usedBlocks[ aligned ] = block;
+		_usedSize += size;
+
+		offset = aligned;
+		return true;
+	}
+
+	return false;
+}
+
+void GL3::BufferPool::release( unsigned int offset )
+{
+	auto it = _usedBlocks.find( offset );
+	if ( it == _usedBlocks.end() ) {
+		return;
+	}
+
+	_usedSize -= it->second.size;
+	addFreeBlock( offset, it->second.size );
+	_usedBlocks.erase( it );
+}
+
+void GL3::BufferPool::addFreeBlock( unsigned int offset, unsigned int size )
+{
+	auto next = _freeBlocks.lower_bound( offset );
+	if ( next != _freeBlocks.end() && offset + size == next->first ) {
+		size += next->second;
+		next = _freeBlocks.erase( next );
+	}
+
+	if ( next != _freeBlocks.begin() ) {
+		auto previous = next;
+		--previous;
+		if ( previous->first + previous->second == offset ) {
+			previous->second += size;
+			return;
+		}
+	}
+
+	_freeBlocks[ offset ] = size;
+}
+
+void GL3::BufferPool::createBuffer( void )
+{
+	glGenBuffers( 1, &_bufferId );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, _bufferId );
+	glBufferData( GL_COPY_WRITE_BUFFER, _capacity, nullptr, GL_STATIC_DRAW );
+}
+
+void GL3::BufferPool::upload( unsigned int offset, const void *data, unsigned int size )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	if ( _bufferId == 0 ) {
+		createBuffer();
+	}
+
+	glBindBuffer( GL_COPY_WRITE_BUFFER, _bufferId );
+	glBufferSubData( GL_COPY_WRITE_BUFFER, offset, size, data );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+bool GL3::BufferPool::shouldDefragment( void ) const
+{
+	return _usedSize > 0 && _usedSize * 2 < _capacity && _freeBlocks.size() >= DEFRAGMENT_MIN_FREE_BLOCKS;
+}
+
+void GL3::BufferPool::defragment( std::function< void( int, unsigned int ) > relocated )
+{
+	if ( _bufferId == 0 || _usedBlocks.empty() ) {
+		return;
+	}
+
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	// live blocks are packed into a scratch buffer and copied back 
+	// in one go, so the pool keeps its GL name and vertex arrays 
+	// pointing at it stay valid
+	std::map< unsigned int, Block > packed;
+	unsigned int cursor = 0;
+	for ( auto &it : _usedBlocks ) {
+		cursor = ( ( cursor + it.second.alignment - 1 ) / it.second.alignment ) * it.second.alignment;
+		packed[ cursor ] = it.second;
+		cursor += it.second.size;
+	}
+
+	GLuint scratchId;
+	glGenBuffers( 1, &scratchId );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, scratchId );
+	glBufferData( GL_COPY_WRITE_BUFFER, cursor, nullptr, GL_STREAM_COPY );
+	glBindBuffer( GL_COPY_READ_BUFFER, _bufferId );
+
+	auto target = packed.begin();
+	for ( auto &it : _usedBlocks ) {
+		glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, it.first, target->first, it.second.size );
+		++target;
+	}
+
+	glBindBuffer( GL_COPY_READ_BUFFER, scratchId );
+	glBindBuffer( GL_COPY_WRITE_BUFFER, _bufferId );
+	glCopyBufferSubData( GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, cursor );
+	glDeleteBuffers( 1, &scratchId );
+
+	_usedBlocks.swap( packed );
+	_freeBlocks.clear();
+	if ( cursor < _capacity ) {
+		_freeBlocks[ cursor ] = _capacity - cursor;
+	}
+
+	for ( auto &it : _usedBlocks ) {
+		relocated( it.second.owner, it.first );
+	}
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+void GL3::BufferPool::unload( void )
+{
+	if ( _bufferId > 0 ) {
+		glDeleteBuffers( 1, &_bufferId );
+		_bufferId = 0;
+	}
+
+	_usedBlocks.clear();
+	_freeBlocks.clear();
+	_freeBlocks[ 0 ] = _capacity;
+	_usedSize = 0;
+}
+
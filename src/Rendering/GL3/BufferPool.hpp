@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_BUFFER_POOL_
+#define CRIMILD_GL3_BUFFER_POOL_
+
+#include <Crimild.hpp>
+
+#include <functional>
+#include <map>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Large GL buffer sub-allocated between many small resources
+
+			Free space is tracked as a list of blocks sorted by offset. 
+			Allocation is first fit, and released blocks are merged with 
+			their free neighbours. Once occupancy drops and free space is 
+			split in many holes, defragment() packs live blocks at the 
+			start of the buffer and reports where each one moved.
+
+			Uploads and copies go through the GL_COPY_WRITE_BUFFER and 
+			GL_COPY_READ_BUFFER targets, so they never modify the element 
+			array binding of the current vertex array.
+		*/
+		class BufferPool {
+		public:
+			BufferPool( unsigned int capacity );
+			virtual ~BufferPool( void );
+
+			unsigned int getBufferId( void ) const { return _bufferId; }
+			unsigned int getCapacity( void ) const { return _capacity; }
+			unsigned int getUsedSize( void ) const { return _usedSize; }
+			unsigned int getFreeBlockCount( void ) const { return _freeBlocks.size(); }
+
+			/**
+				\brief Reserves a block whose offset is a multiple of alignment
+
+				\returns false if no free block is large enough
+			*/
+			bool allocate( unsigned int size, unsigned int alignment, int owner, unsigned int &offset );
+			void release( unsigned int offset );
+
+			void upload( unsigned int offset, const void *data, unsigned int size );
+
+			bool shouldDefragment( void ) const;
+
+			/**
+				\brief Packs live blocks at the start of the buffer
+
+				The callback receives the owner and the new offset of every block
+			*/
+			void defragment( std::function< void( int, unsigned int ) > relocated );
+
+			void unload( void );
+
+		private:
+			struct Block {
+				unsigned int size;
+				unsigned int alignment;
+				int owner;
+			};
+
+			void createBuffer( void );
+			void addFreeBlock( unsigned int offset, unsigned int size );
+
+			unsigned int _bufferId;
+			unsigned int _capacity;
+			unsigned int _usedSize;
+			std::map< unsigned int, unsigned int > _freeBlocks;
+			std::map< unsigned int, Block > _usedBlocks;
+		};
+
+		typedef std::shared_ptr< BufferPool > BufferPoolPtr;
+
+	}
+
+}
+
+#endif
+
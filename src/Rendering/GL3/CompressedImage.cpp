@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "CompressedImage.hpp"
+#include "MipChain.hpp"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+using namespace Crimild;
+
+namespace {
+
+	const unsigned int DDS_MAGIC = 0x20534444; // "DDS "
+	const unsigned int DDS_HEADER_SIZE = 124;
+	const unsigned int DDS_DX10_HEADER_SIZE = 20;
+
+	const unsigned int DDSD_CAPS = 0x1;
+	const unsigned int DDSD_HEIGHT = 0x2;
+	const unsigned int DDSD_WIDTH = 0x4;
+	const unsigned int DDSD_PIXELFORMAT = 0x1000;
+	const unsigned int DDSD_MIPMAPCOUNT = 0x20000;
+	const unsigned int DDSD_LINEARSIZE = 0x80000;
+	const unsigned int DDPF_FOURCC = 0x4;
+	const unsigned int DDSCAPS_COMPLEX = 0x8;
+	const unsigned int DDSCAPS_TEXTURE = 0x1000;
+	const unsigned int DDSCAPS_MIPMAP = 0x400000;
+	const unsigned int DDSCAPS2_CUBEMAP = 0x200;
+	const unsigned int DDSCAPS2_VOLUME = 0x200000;
+
+	const unsigned char KTX_IDENTIFIER[ 12 ] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	const unsigned int KTX_ENDIANNESS = 0x04030201;
+	const unsigned int KTX_HEADER_SIZE = 64;
+
+	unsigned int makeFourCC( char a, char b, char c, char d )
+	{
+		return ( unsigned char ) a | ( ( unsigned char ) b << 8 ) | ( ( unsigned char ) c << 16 ) | ( ( unsigned int )( unsigned char ) d << 24 );
+	}
+
+	unsigned int readUInt32( const std::vector< unsigned char > &data, unsigned int offset, bool swap = false )
+	{
+		const unsigned char *p = &data[ offset ];
+		if ( swap ) {
+			return ( ( unsigned int ) p[ 0 ] << 24 ) | ( p[ 1 ] << 16 ) | ( p[ 2 ] << 8 ) | p[ 3 ];
+		}
+
+		return p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( ( unsigned int ) p[ 3 ] << 24 );
+	}
+
+	void writeUInt32( std::ostream &out, unsigned int value )
+	{
+		char bytes[ 4 ] = { 
+			( char )( value & 0xFF ), 
+			( char )( ( value >> 8 ) & 0xFF ), 
+			( char )( ( value >> 16 ) & 0xFF ), 
+			( char )( ( value >> 24 ) & 0xFF ) 
+		};
+		out.write( bytes, 4 );
+	}
+
+	int getFormatFromFourCC( unsigned int fourCC )
+	{
+		if ( fourCC == makeFourCC( 'D', 'X', 'T', '1' ) ) return GL3::CompressedImage::Format::BC1;
+		if ( fourCC == makeFourCC( 'D', 'X', 'T', '3' ) ) return GL3::CompressedImage::Format::BC2;
+		if ( fourCC == makeFourCC( 'D', 'X', 'T', '5' ) ) return GL3::CompressedImage::Format::BC3;
+		if ( fourCC == makeFourCC( 'A', 'T', 'I', '1' ) || fourCC == makeFourCC( 'B', 'C', '4', 'U' ) ) return GL3::CompressedImage::Format::BC4;
+		if ( fourCC == makeFourCC( 'A', 'T', 'I', '2' ) || fourCC == makeFourCC( 'B', 'C', '5', 'U' ) ) return GL3::CompressedImage::Format::BC5;
+		return -1;
+	}
+
+	int getFormatFromDXGI( unsigned int dxgiFormat )
+	{
+		switch ( dxgiFormat ) {
+			case 71: // DXGI_FORMAT_BC1_UNORM
+				return GL3::CompressedImage::Format::BC1_ALPHA;
+
+			case 74: // DXGI_FORMAT_BC2_UNORM
+				return GL3::CompressedImage::Format::BC2;
+
+			case 77: // DXGI_FORMAT_BC3_UNORM
+				return GL3::CompressedImage::Format::BC3;
+
+			case 80: // DXGI_FORMAT_BC4_UNORM
+				return GL3::CompressedImage::Format::BC4;
+
+			case 83: // DXGI_FORMAT_BC5_UNORM
+				return GL3::CompressedImage::Format::BC5;
+
+			case 98: // DXGI_FORMAT_BC7_UNORM
+				return GL3::CompressedImage::Format::BC7;
+
+			default:
+				return -1;
+		}
+	}
+
+	int getFormatFromGL( unsigned int internalFormat )
+	{
+		switch ( internalFormat ) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+				return GL3::CompressedImage::Format::BC1;
+
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+				return GL3::CompressedImage::Format::BC1_ALPHA;
+
+			case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+				return GL3::CompressedImage::Format::BC2;
+
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				return GL3::CompressedImage::Format::BC3;
+
+			case GL_COMPRESSED_RED_RGTC1:
+				return GL3::CompressedImage::Format::BC4;
+
+			case GL_COMPRESSED_RG_RGTC2:
+				return GL3::CompressedImage::Format::BC5;
+
+			case GL_COMPRESSED_RGBA_BPTC_UNORM_ARB:
+				return GL3::CompressedImage::Format::BC7;
+
+			case GL_COMPRESSED_RGB8_ETC2:
+				return GL3::CompressedImage::Format::ETC2_RGB;
+
+			case GL_COMPRESSED_RGBA8_ETC2_EAC:
+				return GL3::CompressedImage::Format::ETC2_RGBA;
+
+			default:
+				return -1;
+		}
+	}
+
+	bool hasExtension( const std::string &path, const std::string &extension )
+	{
+		if ( path.size() < extension.size() ) {
+			return false;
+		}
+
+		std::string suffix = path.substr( path.size() - extension.size() );
+		std::transform( suffix.begin(), suffix.end(), suffix.begin(), ::tolower );
+		return suffix == extension;
+	}
+
+}
+
+unsigned int GL3::CompressedImage::getBlockSize( unsigned int format )
+{
+	switch ( format ) {
+		case Format::BC1:
+		case Format::BC1_ALPHA:
+		case Format::BC4:
+		case Format::ETC2_RGB:
+			return 8;
+
+		default:
+			return 16;
+	}
+}
+
+unsigned int GL3::CompressedImage::computeLevelSize( unsigned int format, unsigned int width, unsigned int height )
+{
+	return std::max( 1u, ( width + 3 ) / 4 ) * std::max( 1u, ( height + 3 ) / 4 ) * getBlockSize( format );
+}
+
+GL3::CompressedImagePtr GL3::CompressedImage::load( std::string path )
+{
+	std::ifstream input( path.c_str(), std::ios::in | std::ios::binary );
+	if ( !input.is_open() ) {
+		Log::Error << "Cannot open compressed image " << path << Log::End;
+		return nullptr;
+	}
+
+	std::vector< unsigned char > data( ( std::istreambuf_iterator< char >( input ) ), std::istreambuf_iterator< char >() );
+
+	CompressedImagePtr image;
+	if ( data.size() >= 4 && readUInt32( data, 0 ) == DDS_MAGIC ) {
+		image = loadDDS( data );
+	}
+	else if ( data.size() >= sizeof( KTX_IDENTIFIER ) && std::equal( KTX_IDENTIFIER, KTX_IDENTIFIER + sizeof( KTX_IDENTIFIER ), data.begin() ) ) {
+		image = loadKTX( data );
+	}
+
+	if ( image == nullptr ) {
+		Log::Error << "Invalid or unsupported compressed image " << path << Log::End;
+	}
+
+	return image;
+}
+
+GL3::CompressedImagePtr GL3::CompressedImage::loadDDS( const std::vector< unsigned char > &data )
+{
+	if ( data.size() < 4 + DDS_HEADER_SIZE || readUInt32( data, 4 ) != DDS_HEADER_SIZE ) {
+		return nullptr;
+	}
+
+	// fields are relative to the header, right after the magic number
+	auto field = [&]( unsigned int index ) { return readUInt32( data, 4 + index * 4 ); };
+
+	unsigned int height = field( 2 );
+	unsigned int width = field( 3 );
+	unsigned int levelCount = std::max( 1u, field( 6 ) );
+	unsigned int pixelFormatFlags = field( 19 );
+	unsigned int fourCC = field( 20 );
+	unsigned int caps2 = field( 27 );
+
+	if ( ( pixelFormatFlags & DDPF_FOURCC ) == 0 || ( caps2 & ( DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME ) ) != 0 ) {
+		return nullptr;
+	}
+
+	unsigned int offset = 4 + DDS_HEADER_SIZE;
+	int format = -1;
+	if ( fourCC == makeFourCC( 'D', 'X', '1', '0' ) ) {
+		if ( data.size() < offset + DDS_DX10_HEADER_SIZE ) {
+			return nullptr;
+		}
+
+		// array size is the fifth field of the extended header
+		if ( readUInt32( data, offset + 16 ) > 1 ) {
+			return nullptr;
+		}
+
+		format = getFormatFromDXGI( readUInt32( data, offset ) );
+		offset += DDS_DX10_HEADER_SIZE;
+	}
+	else {
+		format = getFormatFromFourCC( fourCC );
+	}
+
+	if ( format < 0 || width == 0 || height == 0 ) {
+		return nullptr;
+	}
+
+	// levels past 1x1 are ignored
+	levelCount = std::min( levelCount, MipChain::computeLevelCount( width, height ) );
+
+	CompressedImagePtr image( new CompressedImage( format, width, height ) );
+	for ( unsigned int level = 0; level < levelCount; level++ ) {
+		unsigned int size = computeLevelSize( format, image->getLevelWidth( level ), image->getLevelHeight( level ) );
+		if ( size > data.size() - offset ) {
+			return nullptr;
+		}
+
+		image->addLevel( &data[ offset ], size );
+		offset += size;
+	}
+
+	return image;
+}
+
+GL3::CompressedImagePtr GL3::CompressedImage::loadKTX( const std::vector< unsigned char > &data )
+{
+	if ( data.size() < KTX_HEADER_SIZE ) {
+		return nullptr;
+	}
+
+	// files written on big endian machines are swapped
+	bool swap = readUInt32( data, 12 ) != KTX_ENDIANNESS;
+	auto field = [&]( unsigned int index ) { return readUInt32( data, 16 + index * 4, swap ); };
+
+	unsigned int glType = field( 0 );
+	unsigned int glInternalFormat = field( 3 );
+	unsigned int width = field( 5 );
+	unsigned int height = field( 6 );
+	unsigned int depth = field( 7 );
+	unsigned int arrayElements = field( 8 );
+	unsigned int faces = field( 9 );
+	unsigned int levelCount = std::max( 1u, field( 10 ) );
+	unsigned int keyValueBytes = field( 11 );
+
+	int format = getFormatFromGL( glInternalFormat );
+	if ( glType != 0 || format < 0 || depth > 0 || arrayElements > 0 || faces != 1 || width == 0 || height == 0 ) {
+		return nullptr;
+	}
+
+	if ( keyValueBytes > data.size() - KTX_HEADER_SIZE ) {
+		return nullptr;
+	}
+
+	// levels past 1x1 are ignored
+	levelCount = std::min( levelCount, MipChain::computeLevelCount( width, height ) );
+
+	unsigned int offset = KTX_HEADER_SIZE + keyValueBytes;
+
+	CompressedImagePtr image( new CompressedImage( format, width, height ) );
+	for ( unsigned int level = 0; level < levelCount; level++ ) {
+		if ( offset + 4 > data.size() ) {
+			return nullptr;
+		}
+
+		unsigned int size = readUInt32( data, offset, swap );
+		offset += 4;
+		if ( size > data.size() - offset || size != computeLevelSize( format, image->getLevelWidth( level ), image->getLevelHeight( level ) ) ) {
+			return nullptr;
+		}
+
+		image->addLevel( &data[ offset ], size );
+
+		// levels are padded to a multiple of four bytes
+		offset += ( size + 3 ) & ~3u;
+	}
+
+	return image;
+}
+
+GL3::CompressedImage::CompressedImage( unsigned int format, unsigned int width, unsigned int height )
+	: _format( format ),
+	  _width( width ),
+	  _height( height )
+{
+
+}
+
+GL3::CompressedImage::~CompressedImage( void )
+{
+
+}
+
+unsigned int GL3::CompressedImage::getGLInternalFormat( void ) const
+{
+	switch ( _format ) {
+		case Format::BC1:
+			return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+		case Format::BC1_ALPHA:
+			return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+
+		case Format::BC2:
+			return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+
+		case Format::BC3:
+			return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+		case Format::BC4:
+			return GL_COMPRESSED_RED_RGTC1;
+
+		case Format::BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+
+		case Format::BC7:
+			return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+
+		case Format::ETC2_RGB:
+			return GL_COMPRESSED_RGB8_ETC2;
+
+		case Format::ETC2_RGBA:
+		default:
+			return GL_COMPRESSED_RGBA8_ETC2_EAC;
+	}
+}
+
+void GL3::CompressedImage::addLevel( const unsigned char *data, unsigned int size )
+{
+	_levels.push_back( std::vector< unsigned char >( data, data + size ) );
+}
+
+unsigned int GL3::CompressedImage::getLevelWidth( unsigned int level ) const
+{
+	return std::max( 1u, _width >> level );
+}
+
+unsigned int GL3::CompressedImage::getLevelHeight( unsigned int level ) const
+{
+	return std::max( 1u, _height >> level );
+}
+
+unsigned int GL3::CompressedImage::getTotalSize( unsigned int firstLevel ) const
+{
+	unsigned int size = 0;
+	for ( unsigned int i = firstLevel; i < _levels.size(); i++ ) {
+		size += _levels[ i ].size();
+	}
+
+	return size;
+}
+
+bool GL3::CompressedImage::save( std::string path ) const
+{
+	if ( _levels.empty() ) {
+		return false;
+	}
+
+	std::ofstream output( path.c_str(), std::ios::out | std::ios::binary );
+	if ( !output.is_open() ) {
+		Log::Error << "Cannot write compressed image " << path << Log::End;
+		return false;
+	}
+
+	bool result = hasExtension( path, ".dds" ) ? saveDDS( output ) : saveKTX( output );
+	return result && output.good();
+}
+
+bool GL3::CompressedImage::saveDDS( std::ostream &out ) const
+{
+	unsigned int fourCC;
+	switch ( _format ) {
+		case Format::BC1:
+		case Format::BC1_ALPHA:
+			fourCC = makeFourCC( 'D', 'X', 'T', '1' );
+			break;
+
+		case Format::BC2:
+			fourCC = makeFourCC( 'D', 'X', 'T', '3' );
+			break;
+
+		case Format::BC3:
+			fourCC = makeFourCC( 'D', 'X', 'T', '5' );
+			break;
+
+		case Format::BC4:
+			fourCC = makeFourCC( 'A', 'T', 'I', '1' );
+			break;
+
+		case Format::BC5:
+			fourCC = makeFourCC( 'A', 'T', 'I', '2' );
+			break;
+
+		default:
+			// no legacy code for the remaining formats
+			Log::Error << "Format cannot be stored in a DDS file, use KTX instead" << Log::End;
+			return false;
+	}
+
+	bool mipmapped = _levels.size() > 1;
+
+	writeUInt32( out, DDS_MAGIC );
+	writeUInt32( out, DDS_HEADER_SIZE );
+	writeUInt32( out, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE | ( mipmapped ? DDSD_MIPMAPCOUNT : 0 ) );
+	writeUInt32( out, _height );
+	writeUInt32( out, _width );
+	writeUInt32( out, _levels[ 0 ].size() );
+	writeUInt32( out, 0 );
+	writeUInt32( out, _levels.size() );
+	for ( unsigned int i = 0; i < 11; i++ ) {
+		writeUInt32( out, 0 );
+	}
+
+	// pixel format
+	writeUInt32( out, 32 );
+	writeUInt32( out, DDPF_FOURCC );
+	writeUInt32( out, fourCC );
+	for ( unsigned int i = 0; i < 5; i++ ) {
+		writeUInt32( out, 0 );
+	}
+
+	writeUInt32( out, DDSCAPS_TEXTURE | ( mipmapped ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0 ) );
+	for ( unsigned int i = 0; i < 4; i++ ) {
+		writeUInt32( out, 0 );
+	}
+
+	for ( auto &level : _levels ) {
+		out.write( ( const char * ) &level[ 0 ], level.size() );
+	}
+
+	return true;
+}
+
+bool GL3::CompressedImage::saveKTX( std::ostream &out ) const
+{
+	unsigned int baseFormat = ( _format == Format::BC1 || _format == Format::ETC2_RGB ) ? GL_RGB 
+		: ( _format == Format::BC4 ? GL_RED : ( _format == Format::BC5 ? GL_RG : GL_RGBA ) );
+
+	out.write( ( const char * ) KTX_IDENTIFIER, sizeof( KTX_IDENTIFIER ) );
+	writeUInt32( out, KTX_ENDIANNESS );
+	writeUInt32( out, 0 ); // glType
+	writeUInt32( out, 1 ); // glTypeSize
+	writeUInt32( out, 0 ); // glFormat
+	writeUInt32( out, getGLInternalFormat() );
+	writeUInt32( out, baseFormat );
+	writeUInt32( out, _width );
+	writeUInt32( out, _height );
+	writeUInt32( out, 0 ); // depth
+	writeUInt32( out, 0 ); // array elements
+	writeUInt32( out, 1 ); // faces
+	writeUInt32( out, _levels.size() );
+	writeUInt32( out, 0 ); // key/value data
+
+	const char padding[ 3 ] = { 0, 0, 0 };
+	for ( auto &level : _levels ) {
+		writeUInt32( out, level.size() );
+		out.write( ( const char * ) &level[ 0 ], level.size() );
+		out.write( padding, ( 4 - level.size() % 4 ) % 4 );
+	}
+
+	return true;
+}
+
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_COMPRESSED_IMAGE_
+#define CRIMILD_GL3_COMPRESSED_IMAGE_
+
+#include <Crimild.hpp>
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		class CompressedImage;
+		typedef std::shared_ptr< CompressedImage > CompressedImagePtr;
+
+		/**
+			\brief Image stored in a GPU block compressed format
+
+			Holds every mipmap level as it is uploaded with 
+			glCompressedTexImage2D. Images are read from and written to 
+			KTX (version 1) and DDS containers, including DDS files with 
+			the DX10 header. Only single 2D images are supported, so 
+			cube maps, arrays and volume textures are rejected.
+
+			Use it like any other image when creating a Texture. The 
+			base Image accessors are left empty, since there are no 
+			uncompressed pixels.
+		*/
+		class CompressedImage : public Image {
+		public:
+			class Format {
+			public:
+				enum {
+					BC1,
+					BC1_ALPHA,
+					BC2,
+					BC3,
+					BC4,
+					BC5,
+					BC7,
+					ETC2_RGB,
+					ETC2_RGBA
+				};
+			};
+
+			/**
+				\brief Size in bytes of a 4x4 block
+			*/
+			static unsigned int getBlockSize( unsigned int format );
+
+			/**
+				\brief Size in bytes of an image, rounded up to whole blocks
+			*/
+			static unsigned int computeLevelSize( unsigned int format, unsigned int width, unsigned int height );
+
+			/**
+				\brief Reads a KTX or DDS file, detected by its contents
+
+				\returns null if the file cannot be read or its format is not supported
+			*/
+			static CompressedImagePtr load( std::string path );
+
+		public:
+			CompressedImage( unsigned int format, unsigned int width, unsigned int height );
+			virtual ~CompressedImage( void );
+
+			unsigned int getFormat( void ) const { return _format; }
+
+			/**
+				\brief Internal format to use with glCompressedTexImage2D
+			*/
+			unsigned int getGLInternalFormat( void ) const;
+
+			/**
+				\brief Appends the next mipmap level
+			*/
+			void addLevel( const unsigned char *data, unsigned int size );
+
+			unsigned int getLevelCount( void ) const { return _levels.size(); }
+			unsigned int getLevelWidth( unsigned int level ) const;
+			unsigned int getLevelHeight( unsigned int level ) const;
+			const unsigned char *getLevelData( unsigned int level ) const { return &_levels[ level ][ 0 ]; }
+			unsigned int getLevelSize( unsigned int level ) const { return _levels[ level ].size(); }
+
+			/**
+				\brief Size in bytes of every level starting at firstLevel
+			*/
+			unsigned int getTotalSize( unsigned int firstLevel = 0 ) const;
+
+			/**
+				\brief Writes the image as KTX or DDS, based on the file extension
+			*/
+			bool save( std::string path ) const;
+
+		private:
+			static CompressedImagePtr loadDDS( const std::vector< unsigned char > &data );
+			static CompressedImagePtr loadKTX( const std::vector< unsigned char > &data );
+			bool saveDDS( std::ostream &out ) const;
+			bool saveKTX( std::ostream &out ) const;
+
+			unsigned int _format;
+			unsigned int _width;
+			unsigned int _height;
+			std::vector< std::vector< unsigned char > > _levels;
+		};
+
+	}
+
+}
+
+#endif
+
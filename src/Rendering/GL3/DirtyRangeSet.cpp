@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DirtyRangeSet.hpp"
+
+#include <algorithm>
+
+using namespace Crimild;
+
+GL3::DirtyRangeSet::DirtyRangeSet( unsigned int maxRanges )
+	: _maxRanges( maxRanges > 0 ? maxRanges : 1 )
+{
+
+}
+
+GL3::DirtyRangeSet::~DirtyRangeSet( void )
+{
+
+}
+
+void GL3::DirtyRangeSet::insert( unsigned int begin, unsigned int end )
+{
+	if ( begin >= end ) {
+		return;
+	}
+
+	// first range ending at or after begin, which is the first one that may touch the new range
+	auto it = std::lower_bound( _ranges.begin(), _ranges.end(), begin, []( const std::pair< unsigned int, unsigned int > &range, unsigned int value ) {
+		return range.second < value;
+	});
+
+	auto last = it;
+	while ( last != _ranges.end() && last->first <= end ) {
+		begin = std::min( begin, last->first );
+		end = std::max( end, last->second );
+		last++;
+	}
+
+	it = _ranges.erase( it, last );
+	_ranges.insert( it, std::make_pair( begin, end ) );
+
+	while ( _ranges.size() > _maxRanges ) {
+		unsigned int closest = 0;
+		for ( unsigned int i = 1; i < _ranges.size() - 1; i++ ) {
+			if ( _ranges[ i + 1 ].first - _ranges[ i ].second < _ranges[ closest + 1 ].first - _ranges[ closest ].second ) {
+				closest = i;
+			}
+		}
+
+		_ranges[ closest ].second = _ranges[ closest + 1 ].second;
+		_ranges.erase( _ranges.begin() + closest + 1 );
+	}
+}
+
+unsigned int GL3::DirtyRangeSet::getCoveredSize( void ) const
+{
+	unsigned int size = 0;
+	for ( auto &range : _ranges ) {
+		size += range.second - range.first;
+	}
+
+	return size;
+}
+
+void GL3::DirtyRangeSet::foreachRange( std::function< void( unsigned int, unsigned int ) > callback ) const
+{
+	for ( auto &range : _ranges ) {
+		callback( range.first, range.second );
+	}
+}
+
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_DIRTY_RANGE_SET_
+#define CRIMILD_GL3_DIRTY_RANGE_SET_
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Small set of disjoint [begin, end) intervals
+
+			Overlapping and adjacent ranges are merged as they are 
+			inserted. Once there are more than maxRanges intervals, the 
+			two separated by the smallest gap are merged, trading a few 
+			redundant elements for fewer buffer updates.
+		*/
+		class DirtyRangeSet {
+		public:
+			static const unsigned int DEFAULT_MAX_RANGES = 8;
+
+		public:
+			DirtyRangeSet( unsigned int maxRanges = DEFAULT_MAX_RANGES );
+			~DirtyRangeSet( void );
+
+			void insert( unsigned int begin, unsigned int end );
+			void clear( void ) { _ranges.clear(); }
+
+			bool isEmpty( void ) const { return _ranges.empty(); }
+			unsigned int getRangeCount( void ) const { return _ranges.size(); }
+
+			/**
+				\brief Total number of elements covered by all ranges
+			*/
+			unsigned int getCoveredSize( void ) const;
+
+			/**
+				\brief Visits ranges in ascending order
+			*/
+			void foreachRange( std::function< void( unsigned int, unsigned int ) > callback ) const;
+
+		private:
+			unsigned int _maxRanges;
+			std::vector< std::pair< unsigned int, unsigned int > > _ranges;
+		};
+
+	}
+
+}
+
+#endif
+
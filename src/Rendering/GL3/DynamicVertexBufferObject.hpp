@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_DYNAMIC_VERTEX_BUFFER_OBJECT_
+#define CRIMILD_GL3_DYNAMIC_VERTEX_BUFFER_OBJECT_
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Vertex buffer whose contents change every frame
+
+			Instead of owning a static GL buffer, the vertex data is 
+			streamed into the renderer's StreamBuffer the first time the 
+			buffer is bound on each frame. Vertices can be modified 
+			through getData() at any point before drawing.
+		*/
+		class DynamicVertexBufferObject : public VertexBufferObject {
+		public:
+			DynamicVertexBufferObject( const VertexFormat &format, unsigned int vertexCount, const float *vertexData );
+			virtual ~DynamicVertexBufferObject( void );
+		};
+
+		typedef std::shared_ptr< DynamicVertexBufferObject > DynamicVertexBufferObjectPtr;
+
+	}
+
+}
+
+#endif
+
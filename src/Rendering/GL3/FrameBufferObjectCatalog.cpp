@@ -26,6 +26,8 @@
  */
 
 #include "FrameBufferObjectCatalog.hpp"
+#include "TextureCatalog.hpp"
+#include "Renderer.hpp"
 #include "Utils.hpp"
 
 #include <GL/glew.h>
@@ -46,9 +48,15 @@ GL3::FrameBufferObjectCatalog::~FrameBufferObjectCatalog( void )
 
 int GL3::FrameBufferObjectCatalog::getNextResourceId( void )
 {
-    GLuint framebufferId;
-    glGenFramebuffers( 1, &framebufferId );
-    return framebufferId;
+    GpuResource resource;
+    glGenFramebuffers( 1, &resource.name );
+    return _resources.create( resource );
+}
+
+unsigned int GL3::FrameBufferObjectCatalog::getFrameBufferName( FrameBufferObject *fbo )
+{
+    GpuResource *resource = _resources.get( fbo->getCatalogId() );
+    return resource != nullptr ? resource->name : 0;
 }
 
 void GL3::FrameBufferObjectCatalog::bind( FrameBufferObject *fbo )
@@ -57,10 +65,10 @@ void GL3::FrameBufferObjectCatalog::bind( FrameBufferObject *fbo )
 
 	Catalog< FrameBufferObject >::bind( fbo );
 
-    glBindFramebuffer( GL_FRAMEBUFFER, fbo->getCatalogId() );
-    glViewport( 0.0f, 0.0f, fbo->getWidth(), fbo->getHeight() );
-    const RGBAColorf &clearColor = fbo->getClearColor();
-    glClearColor( clearColor.r(), clearColor.g(), clearColor.b(), clearColor.a() );
+    StateCache *stateCache = getRenderer()->getStateCache();
+    stateCache->bindFrameBuffer( getFrameBufferName( fbo ) );
+    stateCache->setViewport( 0, 0, fbo->getWidth(), fbo->getHeight() );
+    stateCache->setClearColor( fbo->getClearColor() );
     glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
     CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -70,7 +78,7 @@ void GL3::FrameBufferObjectCatalog::unbind( FrameBufferObject *fbo )
 {
     CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-    glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+    getRenderer()->getStateCache()->bindFrameBuffer( 0 );
 
 	Catalog< FrameBufferObject >::unbind( fbo );
 
@@ -86,9 +94,16 @@ void GL3::FrameBufferObjectCatalog::load( FrameBufferObject *fbo )
     unsigned int width = fbo->getWidth();
     unsigned int height = fbo->getHeight();
 
-    int framebufferId = fbo->getCatalogId();
+    StateCache *stateCache = getRenderer()->getStateCache();
+
+    GpuResource *resource = _resources.get( fbo->getCatalogId() );
+    int framebufferId = resource != nullptr ? resource->name : 0;
     if ( framebufferId > 0 ) {
-        glBindFramebuffer( GL_FRAMEBUFFER, framebufferId );
+        resource->size = width * height * 4;
+        resource->format = GL_RGBA8;
+        resource->lastUseFrame = getRenderer()->getFrameNumber();
+
+        stateCache->bindFrameBuffer( framebufferId );
 
 /*
         aFrameBuffer.renderCache = this.gl.createFramebuffer();
@@ -125,19 +140,21 @@ void GL3::FrameBufferObjectCatalog::load( FrameBufferObject *fbo )
             glBindRenderbuffer( GL_RENDERBUFFER, depthBuffer );
             glRenderbufferStorage( GL_RENDERBUFFER, ( fbo->getDepthBits() == 16 ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT24 ), width, height );
             glFramebufferRenderbuffer( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer );
+            resource->auxName = depthBuffer;
         }
 
         // generate texture that will be used as the rendering target
         GLuint offscreenSurface;
         glGenTextures( 1, &offscreenSurface );
-        glBindTexture( GL_TEXTURE_2D, offscreenSurface );
+        stateCache->bindTexture( 0, GL_TEXTURE_2D, offscreenSurface );
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
         glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
         glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, offscreenSurface, 0 );
-        fbo->getTexture()->setCatalogInfo( getRenderer()->getTextureCatalog(), offscreenSurface );
+        GL3::TextureCatalog *textureCatalog = static_cast< GL3::TextureCatalog * >( getRenderer()->getTextureCatalog() );
+        fbo->getTexture()->setCatalogInfo( textureCatalog, textureCatalog->registerTexture( offscreenSurface, resource->size ) );
 
         GLenum status = glCheckFramebufferStatus( GL_FRAMEBUFFER );
         if ( status != GL_FRAMEBUFFER_COMPLETE ) {
@@ -145,7 +162,7 @@ void GL3::FrameBufferObjectCatalog::load( FrameBufferObject *fbo )
             exit( 1 );
         }
 
-        glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+        stateCache->bindFrameBuffer( 0 );
     }
     else {
         Log::Error << "Cannot create framebuffer object (out of memory?)" << Log::End;
@@ -159,9 +176,16 @@ void GL3::FrameBufferObjectCatalog::unload( FrameBufferObject *fbo )
 {
     CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-    GLuint framebufferId = fbo->getCatalogId();
-    if ( framebufferId > 0 ) {
+    int handle = fbo->getCatalogId();
+    GpuResource *resource = _resources.get( handle );
+    if ( resource != nullptr ) {
+        GLuint framebufferId = resource->name;
         glDeleteFramebuffers( 1, &framebufferId );
+        getRenderer()->getStateCache()->invalidateFrameBuffer( framebufferId );
+        if ( resource->auxName > 0 ) {
+            glDeleteRenderbuffers( 1, &resource->auxName );
+        }
+        _resources.release( handle );
 
         Catalog< FrameBufferObject >::unload( fbo );
     }
@@ -28,18 +28,22 @@
 #ifndef CRIMILD_GL3_CATALOG_FRAME_BUFFER_OBJECT_
 #define CRIMILD_GL3_CATALOG_FRAME_BUFFER_OBJECT_
 
+#include "HandleTable.hpp"
+
 #include <Crimild.hpp>
 
 namespace Crimild {
 
 	namespace GL3 {
 
+		class Renderer;
+
 		class FrameBufferObjectCatalog : public Catalog< FrameBufferObject > {
 		public:
-			FrameBufferObjectCatalog( Crimild::Renderer *renderer );
+			FrameBufferObjectCatalog( Renderer *renderer );
 			virtual ~FrameBufferObjectCatalog( void );
 
-			Crimild::Renderer *getRenderer( void ) { return _renderer; }
+			Renderer *getRenderer( void ) { return _renderer; }
 
 			virtual int getNextResourceId( void ) override;
 
@@ -49,8 +53,14 @@ namespace Crimild {
 			virtual void load( FrameBufferObject *fbo ) override;
 			virtual void unload( FrameBufferObject *fbo ) override;
 
+			/**
+				\brief Returns the GL name for a loaded frame buffer, or zero for the default one
+			*/
+			unsigned int getFrameBufferName( FrameBufferObject *fbo );
+
 		private:
-			Crimild::Renderer *_renderer;
+			Renderer *_renderer;
+			GpuResourceTable _resources;
 		};
 
 		typedef std::shared_ptr< FrameBufferObjectCatalog > FrameBufferObjectCatalogPtr;
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_HANDLE_TABLE_
+#define CRIMILD_GL3_HANDLE_TABLE_
+
+#include <functional>
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Generational slot map producing stable integer handles
+
+			Values are stored densely and addressed through a slot array, 
+			so creating, releasing and looking up entries are O(1). A 
+			handle encodes both the slot index and the slot's generation, 
+			which is bumped whenever the slot is released. Stale handles 
+			are therefore detected instead of aliasing a newer entry.
+
+			Handles are always positive, so they can be used as catalog ids.
+			That leaves 31 bits, split into 16 bits of slot index and 15 
+			of generation. A slot whose generation runs out is retired 
+			instead of wrapping around, so a stale handle can never match 
+			a live one.
+		*/
+		template< typename T >
+		class HandleTable {
+		public:
+			static const unsigned int INDEX_BITS = 16;
+			static const unsigned int GENERATION_BITS = 15;
+			static const unsigned int MAX_GENERATION = ( 1 << GENERATION_BITS ) - 1;
+			static const unsigned int MAX_ENTRIES = ( 1 << INDEX_BITS );
+
+		public:
+			HandleTable( void ) : _freeHead( INVALID_SLOT ) { }
+			~HandleTable( void ) { }
+
+			int create( const T &value )
+			{
+				unsigned int slotIndex;
+				if ( _freeHead != INVALID_SLOT ) {
+					slotIndex = _freeHead;
+					_freeHead = _slots[ slotIndex ].index;
+				}
+				else {
+					slotIndex = _slots.size();
+					if ( slotIndex >= MAX_ENTRIES ) {
+						return 0;
+					}
+
+					Slot slot;
+					slot.generation = 1;
+					_slots.push_back( slot );
+				}
+
+				Slot &slot = _slots[ slotIndex ];
+				slot.index = _values.size();
+				_values.push_back( value );
+				_owners.push_back( slotIndex );
+
+				return ( int )( ( slot.generation << INDEX_BITS ) | slotIndex );
+			}
+
+			T *get( int handle )
+			{
+				Slot *slot = getSlot( handle );
+				return slot != nullptr ? &_values[ slot->index ] : nullptr;
+			}
+
+			bool contains( int handle ) { return getSlot( handle ) != nullptr; }
+
+			bool release( int handle )
+			{
+				Slot *slot = getSlot( handle );
+				if ( slot == nullptr ) {
+					return false;
+				}
+
+				// keep values packed by moving the last one into the hole
+				unsigned int hole = slot->index;
+				unsigned int last = _values.size() - 1;
+				if ( hole != last ) {
+					_values[ hole ] = _values[ last ];
+					_owners[ hole ] = _owners[ last ];
+					_slots[ _owners[ hole ] ].index = hole;
+				}
+				_values.pop_back();
+				_owners.pop_back();
+
+				// exhausted slots stay out of the free list for good
+				if ( slot->generation == MAX_GENERATION ) {
+					slot->generation = RETIRED_GENERATION;
+					slot->index = INVALID_SLOT;
+					return true;
+				}
+
+				++slot->generation;
+
+				unsigned int slotIndex = handle & ( MAX_ENTRIES - 1 );
+				slot->index = _freeHead;
+				_freeHead = slotIndex;
+
+				return true;
+			}
+
+			unsigned int getCount( void ) const { return _values.size(); }
+
+			void foreach( std::function< void( T & ) > callback )
+			{
+				for ( auto &value : _values ) {
+					callback( value );
+				}
+			}
+
+			void clear( void )
+			{
+				_slots.clear();
+				_values.clear();
+				_owners.clear();
+				_freeHead = INVALID_SLOT;
+			}
+
+		private:
+			static const unsigned int INVALID_SLOT = ~0u;
+
+			// never encoded in a handle, so lookups on retired slots fail
+			static const unsigned int RETIRED_GENERATION = 0;
+
+			struct Slot {
+				unsigned int generation;
+				unsigned int index; // dense index while alive, next free slot otherwise
+			};
+
+			Slot *getSlot( int handle )
+			{
+				if ( handle <= 0 ) {
+					return nullptr;
+				}
+
+				unsigned int slotIndex = handle & ( MAX_ENTRIES - 1 );
+				unsigned int generation = ( unsigned int ) handle >> INDEX_BITS;
+				if ( generation == RETIRED_GENERATION || slotIndex >= _slots.size() || _slots[ slotIndex ].generation != generation ) {
+					return nullptr;
+				}
+
+				return &_slots[ slotIndex ];
+			}
+
+			std::vector< Slot > _slots;
+			std::vector< T > _values;
+			std::vector< unsigned int > _owners;
+			unsigned int _freeHead;
+		};
+
+		/**
+			\brief GL names and bookkeeping for a resource owned by a catalog
+		*/
+		struct GpuResource {
+			GpuResource( void ) : name( 0 ), auxName( 0 ), offset( 0 ), size( 0 ), format( 0 ), lastUseFrame( 0 ), storeGeneration( 0 ) { }
+
+			unsigned int name;
+			unsigned int auxName;
+			unsigned int offset;
+			unsigned int size;
+			unsigned int format;
+			unsigned int lastUseFrame;
+			unsigned int storeGeneration; // for data living in a shared store that may be reallocated
+		};
+
+		typedef HandleTable< GpuResource > GpuResourceTable;
+
+	}
+
+}
+
+#endif
+
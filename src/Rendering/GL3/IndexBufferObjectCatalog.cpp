@@ -26,12 +26,25 @@
  */
 
 #include "IndexBufferObjectCatalog.hpp"
+#include "Renderer.hpp"
 
 #include <GL/glfw.h>
 
+#include <algorithm>
+
 using namespace Crimild;
 
-GL3::IndexBufferObjectCatalog::IndexBufferObjectCatalog( void )
+namespace {
+
+	const unsigned int MAX_POOLED_BUFFER_SIZE = 64 * 1024;
+	const unsigned int INDEX_POOL_CAPACITY = 1024 * 1024;
+
+	const unsigned int INDEX_ALIGNMENT = sizeof( GLushort );
+
+}
+
+GL3::IndexBufferObjectCatalog::IndexBufferObjectCatalog( Renderer *renderer )
+	: _renderer( renderer )
 {
 
 }
@@ -43,16 +56,21 @@ GL3::IndexBufferObjectCatalog::~IndexBufferObjectCatalog( void )
 
 int GL3::IndexBufferObjectCatalog::getNextResourceId( void )
 {
-    GLuint id;
-    glGenBuffers( 1, &id );
-    return id;
+    // storage is either sub-allocated or created on load
+    return _resources.create( GpuResource() );
 }
 
 void GL3::IndexBufferObjectCatalog::bind( ShaderProgram *program, IndexBufferObject *ibo )
 {
 	Catalog< IndexBufferObject >::bind( program, ibo );
 
-	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo->getCatalogId() );
+	updateDirtyRanges( ibo );
+
+	GpuResource *resource = getResource( ibo );
+	if ( resource != nullptr ) {
+		resource->lastUseFrame = getRenderer()->getFrameNumber();
+		glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, resource->name );
+	}
 }
 
 void GL3::IndexBufferObjectCatalog::unbind( ShaderProgram *program, IndexBufferObject *ibo )
@@ -66,18 +84,128 @@ void GL3::IndexBufferObjectCatalog::load( IndexBufferObject *ibo )
 {
 	Catalog< IndexBufferObject >::load( ibo );
 
-	int id = ibo->getCatalogId();
-	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, id );
+	unsigned int indexCount = ibo->getIndexCount();
+
+	GpuResource *resource = getResource( ibo );
+	resource->size = indexCount * sizeof( GLushort );
+	resource->format = GL_UNSIGNED_SHORT;
+	resource->lastUseFrame = getRenderer()->getFrameNumber();
+
+	const void *data = indexCount > 0 ? ibo->getData() : nullptr;
+	if ( resource->size > 0 && resource->size <= MAX_POOLED_BUFFER_SIZE && loadPooled( ibo, resource, data ) ) {
+		return;
+	}
+
+	glGenBuffers( 1, &resource->name );
+	glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, resource->name );
 	glBufferData( GL_ELEMENT_ARRAY_BUFFER, 
-		sizeof( unsigned short ) * ibo->getIndexCount(), 
-		ibo->getData(), 
+		resource->size, 
+		data, 
 		GL_STATIC_DRAW );
 }
 
+void GL3::IndexBufferObjectCatalog::invalidate( IndexBufferObject *ibo, unsigned int firstIndex, unsigned int indexCount )
+{
+	if ( getResource( ibo ) == nullptr ) {
+		return;
+	}
+
+	unsigned int end = std::min( firstIndex + indexCount, ibo->getIndexCount() );
+	_dirtyRanges[ ibo->getCatalogId() ].insert( firstIndex, end );
+}
+
+void GL3::IndexBufferObjectCatalog::updateDirtyRanges( IndexBufferObject *ibo )
+{
+	auto it = _dirtyRanges.find( ibo->getCatalogId() );
+	if ( it == _dirtyRanges.end() ) {
+		return;
+	}
+
+	DirtyRangeSet ranges = it->second;
+	_dirtyRanges.erase( it );
+
+	GpuResource *resource = getResource( ibo );
+	if ( resource == nullptr ) {
+		return;
+	}
+
+	const unsigned short *indices = ibo->getData();
+
+	// the copy target leaves the element array binding of the current vertex array untouched
+	glBindBuffer( GL_COPY_WRITE_BUFFER, resource->name );
+	ranges.foreachRange( [&]( unsigned int begin, unsigned int end ) {
+		glBufferSubData( GL_COPY_WRITE_BUFFER, resource->offset + begin * sizeof( GLushort ), ( end - begin ) * sizeof( GLushort ), indices + begin );
+	});
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+bool GL3::IndexBufferObjectCatalog::loadPooled( IndexBufferObject *ibo, GpuResource *resource, const void *data )
+{
+	int handle = ibo->getCatalogId();
+
+	BufferPool *target = nullptr;
+	for ( auto &pool : _indexPools ) {
+		if ( pool->allocate( resource->size, INDEX_ALIGNMENT, handle, resource->offset ) ) {
+			target = pool.get();
+			break;
+		}
+	}
+
+	if ( target == nullptr ) {
+		_indexPools.push_back( BufferPoolPtr( new BufferPool( INDEX_POOL_CAPACITY ) ) );
+		target = _indexPools.back().get();
+		if ( !target->allocate( resource->size, INDEX_ALIGNMENT, handle, resource->offset ) ) {
+			_indexPools.pop_back();
+			return false;
+		}
+	}
+
+	target->upload( resource->offset, data, resource->size );
+	resource->name = target->getBufferId();
+
+	return true;
+}
+
+GL3::BufferPool *GL3::IndexBufferObjectCatalog::getPool( GpuResource *resource )
+{
+	for ( auto &pool : _indexPools ) {
+		if ( pool->getBufferId() != 0 && pool->getBufferId() == resource->name ) {
+			return pool.get();
+		}
+	}
+
+	return nullptr;
+}
+
+unsigned int GL3::IndexBufferObjectCatalog::getByteOffset( IndexBufferObject *ibo )
+{
+	GpuResource *resource = getResource( ibo );
+	return resource != nullptr ? resource->offset : 0;
+}
+
 void GL3::IndexBufferObjectCatalog::unload( IndexBufferObject *ibo )
 {
-	GLuint bufferId = ibo->getCatalogId();
-	glDeleteBuffers( 1, &bufferId );
+	int handle = ibo->getCatalogId();
+	GpuResource *resource = _resources.get( handle );
+	if ( resource != nullptr ) {
+		BufferPool *pool = getPool( resource );
+		if ( pool != nullptr ) {
+			pool->release( resource->offset );
+			if ( pool->shouldDefragment() ) {
+				pool->defragment( [&]( int owner, unsigned int offset ) {
+					GpuResource *moved = _resources.get( owner );
+					if ( moved != nullptr ) {
+						moved->offset = offset;
+					}
+				});
+			}
+		}
+		else {
+			glDeleteBuffers( 1, &resource->name );
+		}
+		_resources.release( handle );
+		_dirtyRanges.erase( handle );
+	}
 
 	Catalog< IndexBufferObject >::unload( ibo );
 }
@@ -28,17 +28,38 @@
 #ifndef CRIMILD_GL3_INDEX_BUFFER_OBJECT_CATALOG_
 #define CRIMILD_GL3_INDEX_BUFFER_OBJECT_CATALOG_
 
+#include "HandleTable.hpp"
+#include "BufferPool.hpp"
+#include "DirtyRangeSet.hpp"
+
 #include <Crimild.hpp>
 
+#include <map>
+#include <vector>
+
 namespace Crimild {
 
 	namespace GL3 {
 
+		class Renderer;
+
+		/**
+			\brief Uploads index buffers, sub-allocating small ones from shared pools
+
+			Indices are uploaded as stored and drawn as GL_UNSIGNED_SHORT.
+
+			\remarks IndexBufferObject only stores 16-bit indices, so meshes 
+			with more than 65535 vertices still have to be split. Selecting 
+			a wider index type per buffer is blocked until the core can 
+			store 32-bit indices.
+		*/
 		class IndexBufferObjectCatalog : public Catalog< IndexBufferObject > {
 		public:
-			IndexBufferObjectCatalog( void );
+			IndexBufferObjectCatalog( Renderer *renderer );
 			virtual ~IndexBufferObjectCatalog( void );
 
+			Renderer *getRenderer( void ) { return _renderer; }
+
 			virtual int getNextResourceId( void ) override;
 
 			virtual void bind( ShaderProgram *program, IndexBufferObject *ibo ) override;
@@ -46,6 +67,38 @@ namespace Crimild {
 
 			virtual void load( IndexBufferObject *ibo ) override;
 			virtual void unload( IndexBufferObject *ibo ) override;
+
+			/**
+				\brief Returns the GL name and metadata for a loaded buffer, or null
+			*/
+			GpuResource *getResource( IndexBufferObject *ibo ) { return _resources.get( ibo->getCatalogId() ); }
+
+			unsigned int getResourceCount( void ) const { return _resources.getCount(); }
+
+			/**
+				\brief Byte offset of the buffer's first index in its GL buffer
+
+				Small index buffers are sub-allocated from shared pools.
+			*/
+			unsigned int getByteOffset( IndexBufferObject *ibo );
+
+			/**
+				\brief Marks a range of indices as modified
+
+				Modified ranges are merged and uploaded the next time the 
+				buffer is bound.
+			*/
+			void invalidate( IndexBufferObject *ibo, unsigned int firstIndex, unsigned int indexCount );
+
+		private:
+			void updateDirtyRanges( IndexBufferObject *ibo );
+			bool loadPooled( IndexBufferObject *ibo, GpuResource *resource, const void *data );
+			BufferPool *getPool( GpuResource *resource );
+
+			Renderer *_renderer;
+			GpuResourceTable _resources;
+			std::vector< BufferPoolPtr > _indexPools;
+			std::map< int, DirtyRangeSet > _dirtyRanges;
 		};
 
 	}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "InstanceBuffer.hpp"
+#include "ShaderProgramCatalog.hpp"
+#include "Utils.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+using namespace Crimild;
+
+namespace {
+
+	void setAttributeDivisor( GLuint index, GLuint divisor )
+	{
+		if ( GLEW_VERSION_3_3 ) {
+			glVertexAttribDivisor( index, divisor );
+		}
+		else {
+			glVertexAttribDivisorARB( index, divisor );
+		}
+	}
+
+}
+
+GL3::InstanceBuffer::InstanceBuffer( void )
+	: _bufferId( 0 )
+{
+
+}
+
+GL3::InstanceBuffer::~InstanceBuffer( void )
+{
+
+}
+
+void GL3::InstanceBuffer::upload( const float *data, unsigned int instanceCount )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	if ( _bufferId == 0 ) {
+		glGenBuffers( 1, &_bufferId );
+	}
+
+	// respecifying the whole store lets the driver orphan the 
+	// previous contents instead of waiting for pending draws
+	glBindBuffer( GL_ARRAY_BUFFER, _bufferId );
+	glBufferData( GL_ARRAY_BUFFER, instanceCount * FLOATS_PER_INSTANCE * sizeof( float ), data, GL_STREAM_DRAW );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+void GL3::InstanceBuffer::bindAttributes( void )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	glBindBuffer( GL_ARRAY_BUFFER, _bufferId );
+
+	GLsizei stride = FLOATS_PER_INSTANCE * sizeof( float );
+	float *baseOffset = 0;
+
+	// a mat4 attribute takes four consecutive slots, one per column
+	for ( unsigned int column = 0; column < 4; column++ ) {
+		GLuint index = ShaderProgramCatalog::AttributeSlot::INSTANCE_MODEL_MATRIX + column;
+		glEnableVertexAttribArray( index );
+		glVertexAttribPointer( index, 4, GL_FLOAT, GL_FALSE, stride, ( const GLvoid * )( baseOffset + 4 * column ) );
+		setAttributeDivisor( index, 1 );
+	}
+
+	GLuint colorIndex = ShaderProgramCatalog::AttributeSlot::INSTANCE_COLOR;
+	glEnableVertexAttribArray( colorIndex );
+	glVertexAttribPointer( colorIndex, 4, GL_FLOAT, GL_FALSE, stride, ( const GLvoid * )( baseOffset + 16 ) );
+	setAttributeDivisor( colorIndex, 1 );
+
+	GLuint layerIndex = ShaderProgramCatalog::AttributeSlot::INSTANCE_LAYER;
+	glEnableVertexAttribArray( layerIndex );
+	glVertexAttribPointer( layerIndex, 1, GL_FLOAT, GL_FALSE, stride, ( const GLvoid * )( baseOffset + 20 ) );
+	setAttributeDivisor( layerIndex, 1 );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+void GL3::InstanceBuffer::unload( void )
+{
+	if ( _bufferId > 0 ) {
+		glDeleteBuffers( 1, &_bufferId );
+		_bufferId = 0;
+	}
+}
+
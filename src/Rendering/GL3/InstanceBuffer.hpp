@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_INSTANCE_BUFFER_
+#define CRIMILD_GL3_INSTANCE_BUFFER_
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Per-instance vertex data for instanced draws
+
+			Each instance is a model matrix, a diffuse color and a color 
+			map layer, fed to the aInstanceModelMatrix, aInstanceColor and 
+			aInstanceLayer attributes with a divisor of one.
+		*/
+		class InstanceBuffer {
+		public:
+			static const unsigned int FLOATS_PER_INSTANCE = 21;
+
+		public:
+			InstanceBuffer( void );
+			virtual ~InstanceBuffer( void );
+
+			void upload( const float *data, unsigned int instanceCount );
+
+			/**
+				\brief Attaches the instance attributes to the vertex array currently bound
+			*/
+			void bindAttributes( void );
+
+			void unload( void );
+
+		private:
+			unsigned int _bufferId;
+		};
+
+		typedef std::shared_ptr< InstanceBuffer > InstanceBufferPtr;
+
+	}
+
+}
+
+#endif
+
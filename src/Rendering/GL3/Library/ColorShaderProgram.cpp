@@ -35,8 +35,10 @@ const char *color_vs = { CRIMILD_TO_STRING(
 	in vec3 aPosition;
 	in vec4 aColor;
 
-	uniform mat4 uPMatrix; 
-	uniform mat4 uVMatrix; 
+	layout ( std140 ) uniform CameraBlock {
+		mat4 uPMatrix;
+		mat4 uVMatrix;
+	};
 	uniform mat4 uMMatrix;
 
 	out vec4 vColor;
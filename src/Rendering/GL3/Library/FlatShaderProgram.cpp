@@ -34,8 +34,10 @@ using namespace Crimild::GL3;
 const char *flat_vs = { CRIMILD_TO_STRING(
 	in vec3 aPosition;
 
-	uniform mat4 uPMatrix; 
-	uniform mat4 uVMatrix; 
+	layout ( std140 ) uniform CameraBlock {
+		mat4 uPMatrix;
+		mat4 uVMatrix;
+	};
 	uniform mat4 uMMatrix;
 
 	void main()
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "InstancedFlatShaderProgram.hpp"
+#include "Rendering/GL3/Utils.hpp"
+
+using namespace Crimild;
+using namespace Crimild::GL3;
+
+const char *instanced_flat_vs = { CRIMILD_TO_STRING(
+	in vec3 aPosition;
+	in mat4 aInstanceModelMatrix;
+	in vec4 aInstanceColor;
+
+	layout ( std140 ) uniform CameraBlock {
+		mat4 uPMatrix;
+		mat4 uVMatrix;
+	};
+
+	out vec4 vColor;
+
+	void main()
+	{
+		vColor = aInstanceColor;
+		gl_Position = uPMatrix * uVMatrix * aInstanceModelMatrix * vec4(aPosition, 1.0); 
+	}
+)};
+
+const char *instanced_flat_fs = { CRIMILD_TO_STRING( 
+	in vec4 vColor;
+
+	out vec4 vFragColor;
+
+	void main( void ) 
+	{ 
+		vFragColor = vColor; 
+	}
+)};
+
+InstancedFlatShaderProgram::InstancedFlatShaderProgram( void )
+	: ShaderProgram( Utils::getVertexShaderInstance( instanced_flat_vs ), Utils::getFragmentShaderInstance( instanced_flat_fs ) )
+{ 
+	registerStandardLocation( ShaderLocation::Type::ATTRIBUTE, ShaderProgram::StandardLocation::POSITION_ATTRIBUTE, "aPosition" );
+
+	registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::PROJECTION_MATRIX_UNIFORM, "uPMatrix" );
+	registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::VIEW_MATRIX_UNIFORM, "uVMatrix" );
+}
+
+InstancedFlatShaderProgram::~InstancedFlatShaderProgram( void )
+{ 
+}
+
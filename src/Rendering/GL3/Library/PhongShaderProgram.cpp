@@ -35,8 +35,10 @@ const char *phong_vs = { CRIMILD_TO_STRING(
 	in vec3 aPosition;
 	in vec3 aNormal;
 
-	uniform mat4 uPMatrix;
-	uniform mat4 uVMatrix;
+	layout ( std140 ) uniform CameraBlock {
+		mat4 uPMatrix;
+		mat4 uVMatrix;
+	};
 	uniform mat4 uMMatrix;
 
 	out vec4 vWorldVertex;
@@ -75,8 +77,10 @@ const char *phong_fs = { CRIMILD_TO_STRING(
 	in vec3 vWorldNormal;
 	in vec3 vViewVec;
 
-	uniform int uLightCount;
-	uniform Light uLights[ 4 ];
+	layout ( std140 ) uniform LightBlock {
+		int uLightCount;
+		Light uLights[ 4 ];
+	};
 	uniform Material uMaterial;
 
 	out vec4 vFragColor;
@@ -129,16 +133,6 @@ PhongShaderProgram::PhongShaderProgram( void )
 	registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::MATERIAL_SHININESS_UNIFORM, "uMaterial.shininess" );
 
 	registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_COUNT_UNIFORM, "uLightCount" );
-
-	for ( int i = 0; i < 4; i++ ) {
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_POSITION_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "position" ) );
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_ATTENUATION_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "attenuation" ) );
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_DIRECTION_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "direction" ) );
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_COLOR_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "color" ) );
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_OUTER_CUTOFF_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "outerCutoff" ) );
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_INNER_CUTOFF_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "innerCutoff" ) );
-		registerStandardLocation( ShaderLocation::Type::UNIFORM, ShaderProgram::StandardLocation::LIGHT_EXPONENT_UNIFORM + i, Utils::buildArrayShaderLocationName( "uLights", i, "exponent" ) );
-	}	
 }
 
 PhongShaderProgram::~PhongShaderProgram( void )
@@ -35,8 +35,10 @@ const char *texture_vs = { CRIMILD_TO_STRING(
 	in vec3 aPosition;
 	in vec2 aTextureCoord;
 
-	uniform mat4 uPMatrix; 
-	uniform mat4 uVMatrix; 
+	layout ( std140 ) uniform CameraBlock {
+		mat4 uPMatrix;
+		mat4 uVMatrix;
+	};
 	uniform mat4 uMMatrix;
 
 	out vec2 vTextureCoord;
@@ -0,0 +1,517 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MeshOptimizer.hpp"
+#include "SubMeshPrimitive.hpp"
+#include "DynamicVertexBufferObject.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+using namespace Crimild;
+
+namespace {
+
+	// scoring constants from Forsyth's "Linear-Speed Vertex Cache Optimisation"
+	const float CACHE_DECAY_POWER = 1.5f;
+	const float LAST_TRIANGLE_SCORE = 0.75f;
+	const float VALENCE_BOOST_SCALE = 2.0f;
+	const float VALENCE_BOOST_POWER = 0.5f;
+
+	const float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;
+
+	float computeVertexScore( int cachePosition, unsigned int remainingTriangles, unsigned int cacheSize )
+	{
+		if ( remainingTriangles == 0 ) {
+			// no triangle left to draw with this vertex
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if ( cachePosition >= 0 ) {
+			if ( cachePosition < 3 ) {
+				// vertices of the last triangle are scored lower, so the 
+				// algorithm does not favor strip-like orders
+				score = LAST_TRIANGLE_SCORE;
+			}
+			else {
+				float scaler = 1.0f / ( cacheSize - 3 );
+				score = std::pow( 1.0f - ( cachePosition - 3 ) * scaler, CACHE_DECAY_POWER );
+			}
+		}
+
+		// boost vertices with few triangles left, so they are finished quickly
+		score += VALENCE_BOOST_SCALE * std::pow( ( float ) remainingTriangles, -VALENCE_BOOST_POWER );
+
+		return score;
+	}
+
+	size_t hashVertex( const float *vertex, unsigned int vertexSize )
+	{
+		// FNV-1a over the bits of each component
+		size_t hash = 2166136261u;
+		for ( unsigned int i = 0; i < vertexSize; i++ ) {
+			// make sure -0 and 0 fall in the same bucket
+			float value = vertex[ i ] == 0.0f ? 0.0f : vertex[ i ];
+			unsigned int bits;
+			memcpy( &bits, &value, sizeof( bits ) );
+			hash = ( hash ^ bits ) * 16777619u;
+		}
+
+		return hash;
+	}
+
+}
+
+float GL3::MeshOptimizer::computeACMR( const unsigned short *indices, unsigned int indexCount, unsigned int cacheSize )
+{
+	unsigned int triangleCount = indexCount / 3;
+	if ( triangleCount == 0 ) {
+		return 0.0f;
+	}
+
+	unsigned int vertexCount = 1 + *std::max_element( indices, indices + indexCount );
+
+	// a vertex is cached if it was inserted within the last cacheSize misses
+	std::vector< unsigned int > insertionTime( vertexCount, 0 );
+	unsigned int misses = 0;
+	for ( unsigned int i = 0; i < triangleCount * 3; i++ ) {
+		unsigned int v = indices[ i ];
+		if ( insertionTime[ v ] == 0 || misses - insertionTime[ v ] >= cacheSize ) {
+			misses++;
+			insertionTime[ v ] = misses;
+		}
+	}
+
+	return ( float ) misses / triangleCount;
+}
+
+GL3::MeshOptimizer::MeshOptimizer( void )
+	: _overdrawThreshold( DEFAULT_OVERDRAW_THRESHOLD )
+{
+	resetStatistics();
+}
+
+GL3::MeshOptimizer::~MeshOptimizer( void )
+{
+
+}
+
+void GL3::MeshOptimizer::resetStatistics( void )
+{
+	memset( &_statistics, 0, sizeof( Statistics ) );
+}
+
+void GL3::MeshOptimizer::optimize( NodePtr node )
+{
+	optimizeNode( node );
+
+	Log::Info << "Optimized " << _statistics.primitiveCount << " primitives (" 
+		<< _statistics.triangleCount << " triangles). "
+		<< "Vertices: " << _statistics.vertexCountBefore << " -> " << _statistics.vertexCountAfter << ". "
+		<< "ACMR: " << _statistics.acmrBefore << " -> " << _statistics.acmrAfter
+		<< Log::End;
+}
+
+void GL3::MeshOptimizer::optimizeNode( NodePtr &node )
+{
+	GroupPtr group = std::dynamic_pointer_cast< Group >( node );
+	if ( group != nullptr ) {
+		group->foreachNode( [&]( NodePtr &child ) {
+			optimizeNode( child );
+		});
+		return;
+	}
+
+	Geometry *geometry = dynamic_cast< Geometry * >( node.get() );
+	if ( geometry != nullptr ) {
+		geometry->foreachPrimitive( [&]( PrimitivePtr &primitive ) {
+			optimize( primitive.get() );
+		});
+	}
+}
+
+bool GL3::MeshOptimizer::optimize( Primitive *primitive )
+{
+	VertexBufferObject *vbo = primitive->getVertexBuffer();
+	IndexBufferObject *ibo = primitive->getIndexBuffer();
+	if ( primitive->getType() != Primitive::Type::TRIANGLES || vbo == nullptr || ibo == nullptr 
+		|| !vbo->getVertexFormat().hasPositions() || ibo->getIndexCount() < 3 || ibo->getIndexCount() % 3 != 0
+		|| dynamic_cast< SubMeshPrimitive * >( primitive ) != nullptr 
+		|| dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+		// sub-meshes share their buffers with other primitives, and
+		// dynamic buffers are rewritten every frame anyway
+		return false;
+	}
+
+	VertexFormat format = vbo->getVertexFormat();
+	unsigned int vertexCount = vbo->getVertexCount();
+
+	const unsigned short *src = ibo->getData();
+	std::vector< unsigned short > indices( src, src + ibo->getIndexCount() );
+	float acmrBefore = computeACMR( &indices[ 0 ], indices.size() );
+
+	_vertices.clear();
+	unsigned int weldedCount = weldVertices( format, vbo->getData(), vertexCount, indices );
+	if ( indices.size() == 0 ) {
+		// nothing but degenerate triangles
+		return false;
+	}
+
+	optimizeVertexCache( indices, weldedCount );
+	optimizeOverdraw( format, indices );
+	unsigned int finalCount = optimizeVertexFetch( format, indices, weldedCount );
+
+	float acmrAfter = computeACMR( &indices[ 0 ], indices.size() );
+
+	primitive->setVertexBuffer( VertexBufferObjectPtr( new VertexBufferObject( format, finalCount, &_vertices[ 0 ] ) ) );
+	primitive->setIndexBuffer( IndexBufferObjectPtr( new IndexBufferObject( indices.size(), &indices[ 0 ] ) ) );
+
+	// averages are weighted by triangle count, like the ratio itself
+	unsigned int triangleCountBefore = ibo->getIndexCount() / 3;
+	unsigned int totalTriangles = _statistics.triangleCount + triangleCountBefore;
+	_statistics.acmrBefore = ( _statistics.acmrBefore * _statistics.triangleCount + acmrBefore * triangleCountBefore ) / totalTriangles;
+	_statistics.acmrAfter = ( _statistics.acmrAfter * _statistics.triangleCount + acmrAfter * triangleCountBefore ) / totalTriangles;
+	_statistics.triangleCount = totalTriangles;
+	_statistics.primitiveCount++;
+	_statistics.vertexCountBefore += vertexCount;
+	_statistics.vertexCountAfter += finalCount;
+
+	_vertices.clear();
+
+	return true;
+}
+
+unsigned int GL3::MeshOptimizer::weldVertices( const VertexFormat &format, const float *vertices, unsigned int vertexCount, std::vector< unsigned short > &indices )
+{
+	unsigned int vertexSize = format.getVertexSize();
+	unsigned int uniqueCount = 0;
+
+	std::unordered_multimap< size_t, unsigned int > buckets;
+	buckets.reserve( vertexCount );
+
+	std::vector< unsigned short > remap( vertexCount );
+	_vertices.reserve( vertexCount * vertexSize );
+
+	for ( unsigned int v = 0; v < vertexCount; v++ ) {
+		const float *vertex = vertices + v * vertexSize;
+		size_t hash = hashVertex( vertex, vertexSize );
+
+		int match = -1;
+		auto range = buckets.equal_range( hash );
+		for ( auto it = range.first; it != range.second; it++ ) {
+			if ( std::equal( vertex, vertex + vertexSize, &_vertices[ it->second * vertexSize ] ) ) {
+				match = it->second;
+				break;
+			}
+		}
+
+		if ( match < 0 ) {
+			match = uniqueCount++;
+			_vertices.insert( _vertices.end(), vertex, vertex + vertexSize );
+			buckets.insert( std::make_pair( hash, match ) );
+		}
+
+		remap[ v ] = match;
+	}
+
+	// welding may collapse triangles, which are dropped
+	unsigned int count = 0;
+	for ( unsigned int i = 0; i < indices.size(); i += 3 ) {
+		unsigned short a = remap[ indices[ i + 0 ] ];
+		unsigned short b = remap[ indices[ i + 1 ] ];
+		unsigned short c = remap[ indices[ i + 2 ] ];
+		if ( a != b && b != c && c != a ) {
+			indices[ count++ ] = a;
+			indices[ count++ ] = b;
+			indices[ count++ ] = c;
+		}
+	}
+	indices.resize( count );
+
+	return uniqueCount;
+}
+
+void GL3::MeshOptimizer::optimizeVertexCache( std::vector< unsigned short > &indices, unsigned int vertexCount )
+{
+	unsigned int triangleCount = indices.size() / 3;
+
+	// triangles using each vertex, packed in a single array
+	std::vector< unsigned int > remaining( vertexCount, 0 );
+	for ( unsigned short index : indices ) {
+		remaining[ index ]++;
+	}
+
+	std::vector< unsigned int > firstTriangle( vertexCount + 1, 0 );
+	for ( unsigned int v = 0; v < vertexCount; v++ ) {
+		firstTriangle[ v + 1 ] = firstTriangle[ v ] + remaining[ v ];
+	}
+
+	std::vector< unsigned int > adjacency( indices.size() );
+	std::vector< unsigned int > cursor( firstTriangle.begin(), firstTriangle.end() - 1 );
+	for ( unsigned int t = 0; t < triangleCount; t++ ) {
+		for ( unsigned int k = 0; k < 3; k++ ) {
+			adjacency[ cursor[ indices[ t * 3 + k ] ]++ ] = t;
+		}
+	}
+
+	std::vector< int > cachePosition( vertexCount, -1 );
+	std::vector< float > vertexScore( vertexCount );
+	for ( unsigned int v = 0; v < vertexCount; v++ ) {
+		vertexScore[ v ] = computeVertexScore( -1, remaining[ v ], CACHE_SIZE );
+	}
+
+	std::vector< float > triangleScore( triangleCount );
+	std::vector< bool > emitted( triangleCount, false );
+	for ( unsigned int t = 0; t < triangleCount; t++ ) {
+		triangleScore[ t ] = vertexScore[ indices[ t * 3 + 0 ] ] + vertexScore[ indices[ t * 3 + 1 ] ] + vertexScore[ indices[ t * 3 + 2 ] ];
+	}
+
+	std::vector< unsigned short > result;
+	result.reserve( indices.size() );
+
+	// most recently used first, with room for the vertices of one more triangle
+	std::vector< unsigned int > cache;
+	cache.reserve( CACHE_SIZE + 3 );
+
+	std::vector< unsigned int > touched;
+	touched.reserve( CACHE_SIZE + 3 );
+
+	int best = std::max_element( triangleScore.begin(), triangleScore.end() ) - triangleScore.begin();
+	unsigned int scanCursor = 0;
+
+	while ( result.size() < indices.size() ) {
+		if ( best < 0 ) {
+			// no candidate left in the cache, continue with the next triangle in the input order
+			while ( emitted[ scanCursor ] ) {
+				scanCursor++;
+			}
+			best = scanCursor;
+		}
+
+		emitted[ best ] = true;
+		for ( unsigned int k = 0; k < 3; k++ ) {
+			unsigned int v = indices[ best * 3 + k ];
+			result.push_back( v );
+
+			// remove the triangle from the list of pending ones for this vertex
+			unsigned int begin = firstTriangle[ v ];
+			unsigned int end = begin + remaining[ v ];
+			for ( unsigned int i = begin; i < end; i++ ) {
+				if ( adjacency[ i ] == ( unsigned int ) best ) {
+					std::swap( adjacency[ i ], adjacency[ end - 1 ] );
+					break;
+				}
+			}
+			remaining[ v ]--;
+
+			auto it = std::find( cache.begin(), cache.end(), v );
+			if ( it != cache.end() ) {
+				cache.erase( it );
+			}
+			cache.insert( cache.begin(), v );
+		}
+
+		touched.assign( cache.begin(), cache.end() );
+		if ( cache.size() > CACHE_SIZE ) {
+			for ( unsigned int i = CACHE_SIZE; i < cache.size(); i++ ) {
+				cachePosition[ cache[ i ] ] = -1;
+			}
+			cache.resize( CACHE_SIZE );
+		}
+
+		for ( unsigned int i = 0; i < cache.size(); i++ ) {
+			cachePosition[ cache[ i ] ] = i;
+		}
+
+		for ( unsigned int v : touched ) {
+			vertexScore[ v ] = computeVertexScore( cachePosition[ v ], remaining[ v ], CACHE_SIZE );
+		}
+
+		// only triangles around touched vertices change their score
+		best = -1;
+		float bestScore = -1.0f;
+		for ( unsigned int v : touched ) {
+			for ( unsigned int i = firstTriangle[ v ]; i < firstTriangle[ v ] + remaining[ v ]; i++ ) {
+				unsigned int t = adjacency[ i ];
+				triangleScore[ t ] = vertexScore[ indices[ t * 3 + 0 ] ] + vertexScore[ indices[ t * 3 + 1 ] ] + vertexScore[ indices[ t * 3 + 2 ] ];
+				if ( triangleScore[ t ] > bestScore ) {
+					bestScore = triangleScore[ t ];
+					best = t;
+				}
+			}
+		}
+	}
+
+	indices.swap( result );
+}
+
+void GL3::MeshOptimizer::optimizeOverdraw( const VertexFormat &format, std::vector< unsigned short > &indices )
+{
+	unsigned int triangleCount = indices.size() / 3;
+	if ( _overdrawThreshold <= 1.0f || triangleCount < 2 ) {
+		return;
+	}
+
+	unsigned int vertexSize = format.getVertexSize();
+	unsigned int positionsOffset = format.getPositionsOffset();
+	unsigned int vertexCount = _vertices.size() / vertexSize;
+
+	// split the cache optimized order into clusters wherever the 
+	// simulated cache has to start over, so clusters can be moved 
+	// around without adding many misses
+	std::vector< unsigned int > clusterStarts;
+	std::vector< unsigned int > insertionTime( vertexCount, 0 );
+	unsigned int misses = 0;
+	for ( unsigned int t = 0; t < triangleCount; t++ ) {
+		unsigned int triangleMisses = 0;
+		for ( unsigned int k = 0; k < 3; k++ ) {
+			unsigned int v = indices[ t * 3 + k ];
+			if ( insertionTime[ v ] == 0 || misses - insertionTime[ v ] >= CACHE_SIZE ) {
+				misses++;
+				triangleMisses++;
+				insertionTime[ v ] = misses;
+			}
+		}
+
+		if ( t == 0 || triangleMisses == 3 ) {
+			clusterStarts.push_back( t );
+		}
+	}
+	clusterStarts.push_back( triangleCount );
+
+	unsigned int clusterCount = clusterStarts.size() - 1;
+	if ( clusterCount < 2 ) {
+		return;
+	}
+
+	// area weighted centroid and normal of each cluster
+	std::vector< float > clusterData( clusterCount * 7, 0.0f );
+	float meshCentroid[ 3 ] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+	for ( unsigned int c = 0; c < clusterCount; c++ ) {
+		float *centroid = &clusterData[ c * 7 + 0 ];
+		float *normal = &clusterData[ c * 7 + 3 ];
+		float &area = clusterData[ c * 7 + 6 ];
+
+		for ( unsigned int t = clusterStarts[ c ]; t < clusterStarts[ c + 1 ]; t++ ) {
+			const float *p0 = &_vertices[ indices[ t * 3 + 0 ] * vertexSize + positionsOffset ];
+			const float *p1 = &_vertices[ indices[ t * 3 + 1 ] * vertexSize + positionsOffset ];
+			const float *p2 = &_vertices[ indices[ t * 3 + 2 ] * vertexSize + positionsOffset ];
+
+			float e1[ 3 ] = { p1[ 0 ] - p0[ 0 ], p1[ 1 ] - p0[ 1 ], p1[ 2 ] - p0[ 2 ] };
+			float e2[ 3 ] = { p2[ 0 ] - p0[ 0 ], p2[ 1 ] - p0[ 1 ], p2[ 2 ] - p0[ 2 ] };
+			float n[ 3 ] = { 
+				e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ], 
+				e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ], 
+				e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] 
+			};
+			float triangleArea = 0.5f * std::sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+
+			for ( unsigned int k = 0; k < 3; k++ ) {
+				centroid[ k ] += triangleArea * ( p0[ k ] + p1[ k ] + p2[ k ] ) / 3.0f;
+				normal[ k ] += n[ k ];
+			}
+			area += triangleArea;
+		}
+
+		for ( unsigned int k = 0; k < 3; k++ ) {
+			meshCentroid[ k ] += centroid[ k ];
+		}
+		meshArea += area;
+
+		if ( area > 0.0f ) {
+			for ( unsigned int k = 0; k < 3; k++ ) {
+				centroid[ k ] /= area;
+			}
+		}
+	}
+
+	if ( meshArea <= 0.0f ) {
+		return;
+	}
+
+	for ( unsigned int k = 0; k < 3; k++ ) {
+		meshCentroid[ k ] /= meshArea;
+	}
+
+	// clusters facing away from the center are more likely to occlude
+	// others, so they are drawn first
+	std::vector< std::pair< float, unsigned int > > order( clusterCount );
+	for ( unsigned int c = 0; c < clusterCount; c++ ) {
+		const float *centroid = &clusterData[ c * 7 + 0 ];
+		const float *normal = &clusterData[ c * 7 + 3 ];
+		float length = std::sqrt( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+		float key = 0.0f;
+		if ( length > 0.0f ) {
+			for ( unsigned int k = 0; k < 3; k++ ) {
+				key += ( centroid[ k ] - meshCentroid[ k ] ) * normal[ k ] / length;
+			}
+		}
+		order[ c ] = std::make_pair( -key, c );
+	}
+	std::stable_sort( order.begin(), order.end() );
+
+	std::vector< unsigned short > result;
+	result.reserve( indices.size() );
+	for ( auto &it : order ) {
+		unsigned int c = it.second;
+		result.insert( result.end(), indices.begin() + clusterStarts[ c ] * 3, indices.begin() + clusterStarts[ c + 1 ] * 3 );
+	}
+
+	float acmr = computeACMR( &indices[ 0 ], indices.size() );
+	if ( computeACMR( &result[ 0 ], result.size() ) <= acmr * _overdrawThreshold ) {
+		indices.swap( result );
+	}
+}
+
+unsigned int GL3::MeshOptimizer::optimizeVertexFetch( const VertexFormat &format, std::vector< unsigned short > &indices, unsigned int vertexCount )
+{
+	unsigned int vertexSize = format.getVertexSize();
+
+	// number vertices in the order they are first referenced, 
+	// which also discards the unused ones
+	std::vector< int > remap( vertexCount, -1 );
+	std::vector< float > vertices;
+	vertices.reserve( _vertices.size() );
+
+	unsigned int count = 0;
+	for ( unsigned short &index : indices ) {
+		if ( remap[ index ] < 0 ) {
+			remap[ index ] = count++;
+			vertices.insert( vertices.end(), &_vertices[ index * vertexSize ], &_vertices[ index * vertexSize ] + vertexSize );
+		}
+		index = remap[ index ];
+	}
+
+	_vertices.swap( vertices );
+
+	return count;
+}
+
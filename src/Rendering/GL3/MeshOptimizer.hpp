@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_MESH_OPTIMIZER_
+#define CRIMILD_GL3_MESH_OPTIMIZER_
+
+#include <Crimild.hpp>
+
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Rewrites triangle meshes for faster vertex processing
+
+			Each triangle primitive goes through the following steps:
+			- Identical vertices are welded together
+			- Triangles are reordered for the post-transform vertex 
+			cache, using Forsyth's linear-speed algorithm
+			- Runs of triangles are reordered so outward-facing clusters 
+			are drawn first, reducing overdraw, as long as the cache 
+			miss ratio stays within the overdraw threshold
+			- Vertices are renumbered in the order they are first used, 
+			improving fetch locality and dropping unused ones
+
+			New buffers replace the original ones in each primitive.
+
+			\remarks Optimization must happen before primitives are 
+			drawn for the first time, since buffers already loaded into 
+			a catalog are not updated.
+		*/
+		class MeshOptimizer {
+		public:
+			static const unsigned int CACHE_SIZE = 32;
+
+			/**
+				\brief Accumulated results for every optimized primitive
+			*/
+			struct Statistics {
+				unsigned int primitiveCount;
+				unsigned int triangleCount;
+				unsigned int vertexCountBefore;
+				unsigned int vertexCountAfter;
+				float acmrBefore;
+				float acmrAfter;
+			};
+
+			/**
+				\brief Computes the average cache miss ratio of a triangle list
+
+				Cache misses per triangle for a FIFO cache of the given size. 
+				Ranges from 3 (no reuse at all) to about 0.5 for regular grids.
+			*/
+			static float computeACMR( const unsigned short *indices, unsigned int indexCount, unsigned int cacheSize = CACHE_SIZE );
+
+		public:
+			MeshOptimizer( void );
+			virtual ~MeshOptimizer( void );
+
+			/**
+				\brief Largest ACMR increase allowed when reordering for overdraw
+
+				Expressed as a ratio over the vertex cache optimized order. 
+				Use 1 to disable overdraw reordering.
+			*/
+			void setOverdrawThreshold( float value ) { _overdrawThreshold = value; }
+			float getOverdrawThreshold( void ) const { return _overdrawThreshold; }
+
+			/**
+				\brief Optimizes every triangle primitive below node
+
+				Results are reported to the log once done.
+			*/
+			void optimize( NodePtr node );
+
+			/**
+				\brief Optimizes a single primitive
+
+				\returns false if the primitive cannot be optimized 
+				(not an indexed triangle list, or a sub-mesh or 
+				dynamic buffer)
+			*/
+			bool optimize( Primitive *primitive );
+
+			const Statistics &getStatistics( void ) const { return _statistics; }
+			void resetStatistics( void );
+
+		private:
+			void optimizeNode( NodePtr &node );
+			unsigned int weldVertices( const VertexFormat &format, const float *vertices, unsigned int vertexCount, std::vector< unsigned short > &indices );
+			void optimizeVertexCache( std::vector< unsigned short > &indices, unsigned int vertexCount );
+			void optimizeOverdraw( const VertexFormat &format, std::vector< unsigned short > &indices );
+			unsigned int optimizeVertexFetch( const VertexFormat &format, std::vector< unsigned short > &indices, unsigned int vertexCount );
+
+			float _overdrawThreshold;
+			Statistics _statistics;
+			std::vector< float > _vertices;
+		};
+
+	}
+
+}
+
+#endif
+
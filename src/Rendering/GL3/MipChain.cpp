@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Crimild;
+
+unsigned int GL3::MipChain::computeLevelCount( unsigned int width, unsigned int height )
+{
+	unsigned int size = std::max( width, height );
+	unsigned int count = 1;
+	while ( size > 1 ) {
+		size >>= 1;
+		++count;
+	}
+
+	return count;
+}
+
+GL3::MipChain::MipChain( unsigned int width, unsigned int height, unsigned int bpp, const unsigned char *data )
+	: _bpp( bpp )
+{
+	unsigned int levelCount = computeLevelCount( width, height );
+	_levels.resize( levelCount );
+
+	_levels[ 0 ].width = width;
+	_levels[ 0 ].height = height;
+	_levels[ 0 ].data.assign( data, data + width * height * bpp );
+
+	for ( unsigned int i = 1; i < levelCount; i++ ) {
+		downsample( _levels[ i - 1 ], _levels[ i ] );
+	}
+}
+
+GL3::MipChain::~MipChain( void )
+{
+
+}
+
+unsigned int GL3::MipChain::getTotalSize( unsigned int firstLevel ) const
+{
+	unsigned int size = 0;
+	for ( unsigned int i = firstLevel; i < _levels.size(); i++ ) {
+		size += _levels[ i ].data.size();
+	}
+
+	return size;
+}
+
+void GL3::MipChain::downsample( const Level &src, Level &dst )
+{
+	dst.width = std::max( 1u, src.width / 2 );
+	dst.height = std::max( 1u, src.height / 2 );
+	dst.data.resize( dst.width * dst.height * _bpp );
+
+	std::vector< Taps > columns( dst.width );
+	for ( unsigned int x = 0; x < dst.width; x++ ) {
+		computeTaps( src.width, dst.width, x, columns[ x ] );
+	}
+
+	Taps row;
+	for ( unsigned int y = 0; y < dst.height; y++ ) {
+		computeTaps( src.height, dst.height, y, row );
+
+		for ( unsigned int x = 0; x < dst.width; x++ ) {
+			const Taps &column = columns[ x ];
+
+			unsigned char *out = &dst.data[ ( y * dst.width + x ) * _bpp ];
+			for ( unsigned int c = 0; c < _bpp; c++ ) {
+				float sum = 0.0f;
+				for ( unsigned int j = 0; j < row.count; j++ ) {
+					const unsigned char *line = &src.data[ row.index[ j ] * src.width * _bpp ];
+					for ( unsigned int i = 0; i < column.count; i++ ) {
+						sum += row.weight[ j ] * column.weight[ i ] * line[ column.index[ i ] * _bpp + c ];
+					}
+				}
+
+				// rounded to nearest
+				out[ c ] = ( unsigned char ) std::min( 255.0f, sum + 0.5f );
+			}
+		}
+	}
+}
+
+void GL3::MipChain::computeTaps( unsigned int srcSize, unsigned int dstSize, unsigned int i, Taps &taps )
+{
+	if ( srcSize == 1 ) {
+		taps.count = 1;
+		taps.index[ 0 ] = 0;
+		taps.weight[ 0 ] = 1.0f;
+	}
+	else if ( srcSize % 2 == 0 ) {
+		taps.count = 2;
+		taps.index[ 0 ] = 2 * i;
+		taps.index[ 1 ] = 2 * i + 1;
+		taps.weight[ 0 ] = taps.weight[ 1 ] = 0.5f;
+	}
+	else {
+		// each of the n output texels covers (2n + 1) / n input texels, 
+		// so the footprint straddles three of them with sliding weights
+		float n = dstSize;
+		taps.count = 3;
+		taps.index[ 0 ] = 2 * i;
+		taps.index[ 1 ] = 2 * i + 1;
+		taps.index[ 2 ] = 2 * i + 2;
+		taps.weight[ 0 ] = ( n - i ) / ( 2.0f * n + 1.0f );
+		taps.weight[ 1 ] = n / ( 2.0f * n + 1.0f );
+		taps.weight[ 2 ] = ( i + 1.0f ) / ( 2.0f * n + 1.0f );
+	}
+}
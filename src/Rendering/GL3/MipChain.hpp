@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_MIP_CHAIN_
+#define CRIMILD_GL3_MIP_CHAIN_
+
+#include <memory>
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Full chain of mipmap levels built on the CPU
+
+			Each level is half the size of the previous one, rounded down, 
+			to 1x1. Every texel is the average of the 2x2 block it covers 
+			in the previous level. Along odd dimensions each texel covers 
+			one and a half texels of the previous level instead, so three 
+			weighted taps are used and no row or column is dropped.
+			Slower than glGenerateMipmap, but the result does not depend 
+			on the driver and levels can be uploaded selectively.
+		*/
+		class MipChain {
+		public:
+			/**
+				\brief Number of levels in a full chain for the given size
+			*/
+			static unsigned int computeLevelCount( unsigned int width, unsigned int height );
+
+		public:
+			/**
+				\param bpp Bytes per pixel, for 8-bit channels
+			*/
+			MipChain( unsigned int width, unsigned int height, unsigned int bpp, const unsigned char *data );
+			virtual ~MipChain( void );
+
+			unsigned int getBpp( void ) const { return _bpp; }
+			unsigned int getLevelCount( void ) const { return _levels.size(); }
+
+			unsigned int getLevelWidth( unsigned int level ) const { return _levels[ level ].width; }
+			unsigned int getLevelHeight( unsigned int level ) const { return _levels[ level ].height; }
+			const unsigned char *getLevelData( unsigned int level ) const { return &_levels[ level ].data[ 0 ]; }
+			unsigned int getLevelSize( unsigned int level ) const { return _levels[ level ].data.size(); }
+
+			/**
+				\brief Size in bytes of every level starting at firstLevel
+			*/
+			unsigned int getTotalSize( unsigned int firstLevel = 0 ) const;
+
+		private:
+			struct Level {
+				unsigned int width;
+				unsigned int height;
+				std::vector< unsigned char > data;
+			};
+
+			struct Taps {
+				unsigned int count;
+				unsigned int index[ 3 ];
+				float weight[ 3 ];
+			};
+
+			void downsample( const Level &src, Level &dst );
+			static void computeTaps( unsigned int srcSize, unsigned int dstSize, unsigned int i, Taps &taps );
+
+			unsigned int _bpp;
+			std::vector< Level > _levels;
+		};
+
+		typedef std::shared_ptr< MipChain > MipChainPtr;
+
+	}
+
+}
+
+#endif
+
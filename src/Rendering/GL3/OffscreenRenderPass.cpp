@@ -39,14 +39,14 @@ GL3::OffscreenRenderPass::~OffscreenRenderPass( void )
 
 }
 
-void GL3::OffscreenRenderPass::render( Renderer *renderer, VisibilitySet *vs, Camera *camera ) 
+void GL3::OffscreenRenderPass::render( Crimild::Renderer *renderer, VisibilitySet *vs, Camera *camera ) 
 {
 	if ( _offscreenBuffer == nullptr ) {
 		_offscreenBuffer = FrameBufferObjectPtr( new FrameBufferObject( renderer->getScreenBuffer() ) );
 	}
 
 	renderer->bindFrameBuffer( _offscreenBuffer.get() );	
-	RenderPass::render( renderer, vs, camera );
+	SortedRenderPass::render( renderer, vs, camera );
 	renderer->unbindFrameBuffer( _offscreenBuffer.get() );
 
 	RenderPass::render( renderer, _offscreenBuffer.get(), nullptr );
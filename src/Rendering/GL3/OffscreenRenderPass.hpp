@@ -28,13 +28,15 @@
 #ifndef CRIMILD_GL3_RENDER_PASS_OFFSCREEN_
 #define CRIMILD_GL3_RENDER_PASS_OFFSCREEN_
 
+#include "SortedRenderPass.hpp"
+
 #include <Crimild.hpp>
 
 namespace Crimild {
 
 	namespace GL3 {
 
-		class OffscreenRenderPass : public RenderPass {
+		class OffscreenRenderPass : public SortedRenderPass {
 		public:
 			OffscreenRenderPass( void );
 			virtual ~OffscreenRenderPass( void );
@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "PackedVertexLayout.hpp"
+#include "ShaderProgramCatalog.hpp"
+#include "VertexLayout.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Crimild;
+
+namespace {
+
+	const float MAX_HALF_FLOAT = 65504.0f;
+
+	unsigned int alignToWord( unsigned int size )
+	{
+		return ( size + 3 ) & ~3u;
+	}
+
+	unsigned short toHalfFloat( float value )
+	{
+		unsigned int bits;
+		memcpy( &bits, &value, sizeof( float ) );
+
+		unsigned int sign = ( bits >> 16 ) & 0x8000;
+		int exponent = ( int )( ( bits >> 23 ) & 0xFF ) - 127 + 15;
+		unsigned int mantissa = bits & 0x007FFFFF;
+
+		if ( exponent <= 0 ) {
+			// too small for a normalized half, so either a subnormal or zero
+			if ( exponent < -10 ) {
+				return sign;
+			}
+
+			mantissa |= 0x00800000;
+			unsigned int shift = 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			if ( ( mantissa >> ( shift - 1 ) ) & 1 ) {
+				++half;
+			}
+			return sign | half;
+		}
+
+		if ( exponent >= 31 ) {
+			return sign | 0x7C00;
+		}
+
+		// rounding may carry into the exponent, which is still correct
+		unsigned int half = sign | ( exponent << 10 ) | ( mantissa >> 13 );
+		if ( mantissa & 0x00001000 ) {
+			++half;
+		}
+		return half;
+	}
+
+	unsigned int toPackedNormal( const float *normal )
+	{
+		unsigned int packed = 0;
+		for ( unsigned int i = 0; i < 3; i++ ) {
+			int value = ( int ) std::floor( std::max( -1.0f, std::min( 1.0f, normal[ i ] ) ) * 511.0f + 0.5f );
+			packed |= ( ( unsigned int ) value & 0x3FF ) << ( 10 * i );
+		}
+		return packed;
+	}
+
+	bool isInRange( const float *data, unsigned int vertexCount, unsigned int vertexSize, unsigned int offset, unsigned int components, float minValue, float maxValue )
+	{
+		for ( unsigned int i = 0; i < vertexCount; i++ ) {
+			const float *value = data + i * vertexSize + offset;
+			for ( unsigned int j = 0; j < components; j++ ) {
+				if ( !( value[ j ] >= minValue && value[ j ] <= maxValue ) ) {
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	template< typename Layout >
+	bool configureKnownLayout( const GL3::PackedVertexLayout &layout, unsigned int signature, unsigned int byteOffset )
+	{
+		if ( !Layout::matches( layout ) ) {
+			return false;
+		}
+
+		Layout::configureAttributes( signature, byteOffset );
+		return true;
+	}
+
+	template< typename Layout, typename Next, typename... Rest >
+	bool configureKnownLayout( const GL3::PackedVertexLayout &layout, unsigned int signature, unsigned int byteOffset )
+	{
+		return configureKnownLayout< Layout >( layout, signature, byteOffset ) 
+			|| configureKnownLayout< Next, Rest... >( layout, signature, byteOffset );
+	}
+
+
+}
+
+unsigned int GL3::PackedVertexLayout::selectPacking( const VertexFormat &format, const float *data, unsigned int vertexCount, unsigned int requested )
+{
+	unsigned int packing = requested;
+	unsigned int vertexSize = format.getVertexSize();
+
+	if ( !format.hasPositions() 
+		 || !isInRange( data, vertexCount, vertexSize, format.getPositionsOffset(), format.getPositionComponents(), -MAX_HALF_FLOAT, MAX_HALF_FLOAT ) ) {
+		packing &= ~Packing::HALF_POSITIONS;
+	}
+
+	// packed normals are core since 3.3
+	if ( !format.hasNormals() || format.getNormalComponents() != 3 || !( GLEW_VERSION_3_3 || GLEW_ARB_vertex_type_2_10_10_10_rev ) ) {
+		packing &= ~Packing::PACKED_NORMALS;
+	}
+
+	if ( !format.hasTextureCoords() 
+		 || !isInRange( data, vertexCount, vertexSize, format.getTextureCoordsOffset(), format.getTextureCoordComponents(), 0.0f, 1.0f ) ) {
+		packing &= ~Packing::NORMALIZED_TEXTURE_COORDS;
+	}
+
+	if ( !format.hasColors() 
+		 || !isInRange( data, vertexCount, vertexSize, format.getColorsOffset(), format.getColorComponents(), 0.0f, 1.0f ) ) {
+		packing &= ~Packing::NORMALIZED_COLORS;
+	}
+
+	return packing;
+}
+
+GL3::PackedVertexLayout::PackedVertexLayout( const VertexFormat &format, unsigned int packing )
+	: _format( format ),
+	  _packing( packing ),
+	  _stride( 0 ),
+	  _positionsOffset( 0 ),
+	  _normalsOffset( 0 ),
+	  _colorsOffset( 0 ),
+	  _textureCoordsOffset( 0 )
+{
+	if ( _packing == Packing::NONE ) {
+		// mirrors the float layout, so raw vertex data can be used as is
+		_stride = _format.getVertexSizeInBytes();
+		_positionsOffset = _format.getPositionsOffset() * sizeof( float );
+		_normalsOffset = _format.getNormalsOffset() * sizeof( float );
+		_colorsOffset = _format.getColorsOffset() * sizeof( float );
+		_textureCoordsOffset = _format.getTextureCoordsOffset() * sizeof( float );
+		return;
+	}
+
+	if ( _format.hasPositions() ) {
+		_positionsOffset = _stride;
+		_stride += ( _packing & Packing::HALF_POSITIONS ) ? alignToWord( _format.getPositionComponents() * sizeof( unsigned short ) ) : _format.getPositionComponents() * sizeof( float );
+	}
+
+	if ( _format.hasNormals() ) {
+		_normalsOffset = _stride;
+		_stride += ( _packing & Packing::PACKED_NORMALS ) ? sizeof( unsigned int ) : _format.getNormalComponents() * sizeof( float );
+	}
+
+	if ( _format.hasColors() ) {
+		_colorsOffset = _stride;
+		_stride += ( _packing & Packing::NORMALIZED_COLORS ) ? alignToWord( _format.getColorComponents() * sizeof( unsigned char ) ) : _format.getColorComponents() * sizeof( float );
+	}
+
+	if ( _format.hasTextureCoords() ) {
+		_textureCoordsOffset = _stride;
+		_stride += ( _packing & Packing::NORMALIZED_TEXTURE_COORDS ) ? alignToWord( _format.getTextureCoordComponents() * sizeof( unsigned short ) ) : _format.getTextureCoordComponents() * sizeof( float );
+	}
+}
+
+GL3::PackedVertexLayout::~PackedVertexLayout( void )
+{
+
+}
+
+void GL3::PackedVertexLayout::pack( const float *src, unsigned int vertexCount, unsigned char *dst ) const
+{
+	unsigned int vertexSize = _format.getVertexSize();
+
+	if ( _packing == Packing::NONE ) {
+		memcpy( dst, src, vertexCount * _stride );
+		return;
+	}
+
+	memset( dst, 0, vertexCount * _stride );
+
+	for ( unsigned int i = 0; i < vertexCount; i++ ) {
+		const float *vertex = src + i * vertexSize;
+		unsigned char *packed = dst + i * _stride;
+
+		if ( _format.hasPositions() ) {
+			const float *p = vertex + _format.getPositionsOffset();
+			for ( unsigned int j = 0; j < _format.getPositionComponents(); j++ ) {
+				if ( _packing & Packing::HALF_POSITIONS ) {
+					unsigned short half = toHalfFloat( p[ j ] );
+					memcpy( packed + _positionsOffset + j * sizeof( unsigned short ), &half, sizeof( unsigned short ) );
+				}
+				else {
+					memcpy( packed + _positionsOffset + j * sizeof( float ), &p[ j ], sizeof( float ) );
+				}
+			}
+		}
+
+		if ( _format.hasNormals() ) {
+			const float *n = vertex + _format.getNormalsOffset();
+			if ( _packing & Packing::PACKED_NORMALS ) {
+				unsigned int normal = toPackedNormal( n );
+				memcpy( packed + _normalsOffset, &normal, sizeof( unsigned int ) );
+			}
+			else {
+				memcpy( packed + _normalsOffset, n, _format.getNormalComponents() * sizeof( float ) );
+			}
+		}
+
+		if ( _format.hasColors() ) {
+			const float *c = vertex + _format.getColorsOffset();
+			for ( unsigned int j = 0; j < _format.getColorComponents(); j++ ) {
+				if ( _packing & Packing::NORMALIZED_COLORS ) {
+					packed[ _colorsOffset + j ] = ( unsigned char )( c[ j ] * 255.0f + 0.5f );
+				}
+				else {
+					memcpy( packed + _colorsOffset + j * sizeof( float ), &c[ j ], sizeof( float ) );
+				}
+			}
+		}
+
+		if ( _format.hasTextureCoords() ) {
+			const float *uv = vertex + _format.getTextureCoordsOffset();
+			for ( unsigned int j = 0; j < _format.getTextureCoordComponents(); j++ ) {
+				if ( _packing & Packing::NORMALIZED_TEXTURE_COORDS ) {
+					unsigned short value = ( unsigned short )( uv[ j ] * 65535.0f + 0.5f );
+					memcpy( packed + _textureCoordsOffset + j * sizeof( unsigned short ), &value, sizeof( unsigned short ) );
+				}
+				else {
+					memcpy( packed + _textureCoordsOffset + j * sizeof( float ), &uv[ j ], sizeof( float ) );
+				}
+			}
+		}
+	}
+}
+
+void GL3::PackedVertexLayout::configureAttributes( unsigned int signature, unsigned int byteOffset ) const
+{
+	// the most common layouts use attribute setup generated at compile time
+	bool known = configureKnownLayout< 
+		VertexLayout< Position3f, Normal3f, UV2f >,
+		VertexLayout< Position3f, PackedNormal3, NormalizedUV2 >,
+		VertexLayout< Position3f, Normal3f >,
+		VertexLayout< Position3f, PackedNormal3 >,
+		VertexLayout< Position3f, UV2f >,
+		VertexLayout< Position3f, NormalizedUV2 >,
+		VertexLayout< Position3f, Color4f >,
+		VertexLayout< Position3f, NormalizedColor4 >,
+		VertexLayout< Position3f >
+	>( *this, signature, byteOffset );
+
+	if ( known ) {
+		return;
+	}
+
+	if ( _format.hasPositions() ) {
+		unsigned int format = ( _packing & Packing::HALF_POSITIONS ) ? VertexAttributeFormat::HALF_FLOAT : VertexAttributeFormat::FLOAT;
+		VertexLayoutUtils::setAttributePointer( signature, ShaderProgramCatalog::AttributeSlot::POSITION, _format.getPositionComponents(), format, _stride, byteOffset + _positionsOffset );
+	}
+
+	if ( _format.hasNormals() ) {
+		unsigned int format = ( _packing & Packing::PACKED_NORMALS ) ? VertexAttributeFormat::PACKED_INT_2_10_10_10 : VertexAttributeFormat::FLOAT;
+		VertexLayoutUtils::setAttributePointer( signature, ShaderProgramCatalog::AttributeSlot::NORMAL, _format.getNormalComponents(), format, _stride, byteOffset + _normalsOffset );
+	}
+
+	if ( _format.hasColors() ) {
+		unsigned int format = ( _packing & Packing::NORMALIZED_COLORS ) ? VertexAttributeFormat::NORMALIZED_UNSIGNED_BYTE : VertexAttributeFormat::FLOAT;
+		VertexLayoutUtils::setAttributePointer( signature, ShaderProgramCatalog::AttributeSlot::COLOR, _format.getColorComponents(), format, _stride, byteOffset + _colorsOffset );
+	}
+
+	if ( _format.hasTextureCoords() ) {
+		unsigned int format = ( _packing & Packing::NORMALIZED_TEXTURE_COORDS ) ? VertexAttributeFormat::NORMALIZED_UNSIGNED_SHORT : VertexAttributeFormat::FLOAT;
+		VertexLayoutUtils::setAttributePointer( signature, ShaderProgramCatalog::AttributeSlot::TEXTURE_COORD, _format.getTextureCoordComponents(), format, _stride, byteOffset + _textureCoordsOffset );
+	}
+}
+
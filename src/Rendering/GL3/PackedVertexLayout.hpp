@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_PACKED_VERTEX_LAYOUT_
+#define CRIMILD_GL3_PACKED_VERTEX_LAYOUT_
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Compact GPU layout for a float vertex format
+
+			Each attribute can be stored with a smaller component type:
+			half float positions, normals packed as GL_INT_2_10_10_10_REV,
+			texture coordinates as normalized unsigned shorts and colors 
+			as normalized unsigned bytes. Vertices are converted when 
+			uploaded, so the core VertexFormat and the CPU-side data 
+			are left untouched.
+
+			A position, normal and texture coordinate vertex goes from 
+			32 to 16 bytes with every option enabled.
+		*/
+		class PackedVertexLayout {
+		public:
+			class Packing {
+			public:
+				enum {
+					NONE = 0,
+					HALF_POSITIONS = 1 << 0,
+					PACKED_NORMALS = 1 << 1,
+					NORMALIZED_TEXTURE_COORDS = 1 << 2,
+					NORMALIZED_COLORS = 1 << 3
+				};
+			};
+
+			/**
+				\brief Filters the requested packing to what the data supports
+
+				Attributes outside the range of their packed type, like 
+				repeating texture coordinates, keep using floats.
+			*/
+			static unsigned int selectPacking( const VertexFormat &format, const float *data, unsigned int vertexCount, unsigned int requested );
+
+		public:
+			PackedVertexLayout( const VertexFormat &format, unsigned int packing );
+			~PackedVertexLayout( void );
+
+			const VertexFormat &getVertexFormat( void ) const { return _format; }
+
+			unsigned int getPacking( void ) const { return _packing; }
+
+			/**
+				\brief Size of a packed vertex in bytes
+			*/
+			unsigned int getStride( void ) const { return _stride; }
+
+			unsigned int getPositionsOffset( void ) const { return _positionsOffset; }
+			unsigned int getNormalsOffset( void ) const { return _normalsOffset; }
+			unsigned int getColorsOffset( void ) const { return _colorsOffset; }
+			unsigned int getTextureCoordsOffset( void ) const { return _textureCoordsOffset; }
+
+			/**
+				\brief Converts float vertices into the packed layout
+
+				dst must hold at least getStride() * vertexCount bytes
+			*/
+			void pack( const float *src, unsigned int vertexCount, unsigned char *dst ) const;
+
+			/**
+				\brief Sets up attribute pointers for the bound vertex array
+			*/
+			void configureAttributes( unsigned int signature, unsigned int byteOffset ) const;
+
+		private:
+			VertexFormat _format;
+			unsigned int _packing;
+			unsigned int _stride;
+			unsigned int _positionsOffset;
+			unsigned int _normalsOffset;
+			unsigned int _colorsOffset;
+			unsigned int _textureCoordsOffset;
+		};
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "RenderQueue.hpp"
+#include "TextureCatalog.hpp"
+
+#include <cstring>
+
+using namespace Crimild;
+
+GL3::RenderQueue::RenderQueue( void )
+{
+	memset( &_stats, 0, sizeof( Stats ) );
+}
+
+GL3::RenderQueue::~RenderQueue( void )
+{
+
+}
+
+void GL3::RenderQueue::clear( void )
+{
+	_items.clear();
+	_keys.clear();
+	_order.clear();
+}
+
+void GL3::RenderQueue::push( unsigned int layer, Crimild::Renderer *renderer, Geometry *geometry, PrimitivePtr primitive, Material *material, Camera *camera )
+{
+	Item item;
+	item.geometry = geometry;
+	item.primitive = primitive;
+	item.material = material;
+	item.program = material->getProgram();
+	if ( item.program == nullptr ) {
+		item.program = renderer->getFallbackProgram( material, geometry, primitive.get() );
+	}
+
+	item.textureKey = 0;
+	item.textureArray = -1;
+	Texture *colorMap = material->getColorMap();
+	if ( colorMap != nullptr ) {
+		TextureCatalog *textureCatalog = dynamic_cast< TextureCatalog * >( renderer->getTextureCatalog() );
+		if ( textureCatalog != nullptr ) {
+			item.textureArray = textureCatalog->getTextureArrayIndex( colorMap );
+		}
+
+		if ( item.textureArray >= 0 ) {
+			// the top bit keeps array indices apart from catalog ids
+			item.textureKey = 0x800 | ( item.textureArray & 0x7FF );
+		}
+		else {
+			item.textureKey = colorMap->getCatalogId() & 0x7FF;
+		}
+	}
+
+	_items.push_back( item );
+	_keys.push_back( computeSortKey( layer, item, camera ) );
+}
+
+uint64_t GL3::RenderQueue::computeSortKey( unsigned int layer, const Item &item, Camera *camera )
+{
+	uint64_t programId = item.program != nullptr ? ( item.program->getCatalogId() & 0xFFF ) : 0;
+	uint64_t textureId = item.textureKey;
+	uint64_t bufferId = item.primitive->getVertexBuffer() != nullptr ? ( item.primitive->getVertexBuffer()->getCatalogId() & 0xFFF ) : 0;
+
+	// non-negative floats keep their order when compared as integers, 
+	// so the top 24 bits are a cheap quantization of the distance
+	Vector3f delta = item.geometry->getWorld().getTranslate() - camera->getWorld().getTranslate();
+	float distance = delta.getSquaredMagnitude();
+	uint32_t distanceBits;
+	memcpy( &distanceBits, &distance, sizeof( uint32_t ) );
+	uint64_t depth = distanceBits >> 8;
+
+	uint64_t key = ( uint64_t )( layer & 0xF ) << 60;
+
+	AlphaState *alphaState = item.material->getAlphaState();
+	if ( alphaState != nullptr && alphaState->isEnabled() ) {
+		key |= ( uint64_t ) 1 << 59;
+		key |= ( ~depth & 0xFFFFFF ) << 35;
+		key |= programId << 23;
+		key |= textureId << 11;
+		key |= bufferId & 0x7FF;
+	}
+	else {
+		key |= programId << 47;
+		key |= textureId << 35;
+		key |= bufferId << 23;
+		key |= depth >> 1;
+	}
+
+	return key;
+}
+
+void GL3::RenderQueue::sort( void )
+{
+	unsigned int count = _items.size();
+
+	_order.resize( count );
+	_scratch.resize( count );
+	for ( unsigned int i = 0; i < count; i++ ) {
+		_order[ i ] = i;
+	}
+
+	if ( count > 1 ) {
+		// LSD radix sort, one byte at a time
+		for ( unsigned int shift = 0; shift < 64; shift += 8 ) {
+			unsigned int histogram[ 256 ] = { 0 };
+			for ( unsigned int i = 0; i < count; i++ ) {
+				histogram[ ( _keys[ i ] >> shift ) & 0xFF ]++;
+			}
+
+			// skip digits shared by every key
+			if ( histogram[ ( _keys[ 0 ] >> shift ) & 0xFF ] == count ) {
+				continue;
+			}
+
+			unsigned int offset = 0;
+			for ( unsigned int digit = 0; digit < 256; digit++ ) {
+				unsigned int digitCount = histogram[ digit ];
+				histogram[ digit ] = offset;
+				offset += digitCount;
+			}
+
+			for ( unsigned int i = 0; i < count; i++ ) {
+				unsigned int index = _order[ i ];
+				_scratch[ histogram[ ( _keys[ index ] >> shift ) & 0xFF ]++ ] = index;
+			}
+
+			_order.swap( _scratch );
+		}
+	}
+
+	updateStats();
+}
+
+void GL3::RenderQueue::foreachItem( std::function< void( Item & ) > callback )
+{
+	for ( unsigned int index : _order ) {
+		callback( _items[ index ] );
+	}
+}
+
+void GL3::RenderQueue::updateStats( void )
+{
+	memset( &_stats, 0, sizeof( Stats ) );
+	_stats.drawCount = _items.size();
+
+	ShaderProgram *program = nullptr;
+	Texture *texture = nullptr;
+	VertexBufferObject *buffer = nullptr;
+	for ( Item &item : _items ) {
+		if ( item.program != program ) {
+			program = item.program;
+			++_stats.unsortedProgramChanges;
+		}
+		if ( item.material->getColorMap() != texture ) {
+			texture = item.material->getColorMap();
+			++_stats.unsortedTextureChanges;
+		}
+		if ( item.primitive->getVertexBuffer() != buffer ) {
+			buffer = item.primitive->getVertexBuffer();
+			++_stats.unsortedBufferChanges;
+		}
+	}
+
+	program = nullptr;
+	texture = nullptr;
+	buffer = nullptr;
+	for ( unsigned int index : _order ) {
+		Item &item = _items[ index ];
+		if ( item.program != program ) {
+			program = item.program;
+			++_stats.programChanges;
+		}
+		if ( item.material->getColorMap() != texture ) {
+			texture = item.material->getColorMap();
+			++_stats.textureChanges;
+		}
+		if ( item.primitive->getVertexBuffer() != buffer ) {
+			buffer = item.primitive->getVertexBuffer();
+			++_stats.bufferChanges;
+		}
+	}
+}
+
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_RENDER_QUEUE_
+#define CRIMILD_GL3_RENDER_QUEUE_
+
+#include <Crimild.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Sorts draw calls to minimize state changes
+
+			Each draw gets a 64-bit key. From the most significant bits:
+			layer (4 bits), translucency (1 bit), and then either
+			program (12), texture (12), vertex buffer (12) and depth (23)
+			for opaque draws, or inverted depth (24) followed by program,
+			texture and vertex buffer for translucent ones. Sorting the
+			keys in ascending order renders opaque objects grouped by
+			state and front-to-back, then translucent objects back-to-front.
+			Color maps stored in the same texture array share their texture 
+			bits, so draws using any of them end up next to each other. 
+			Texture bits are truncated, so equal bits do not imply the 
+			same texture; compare Item::textureArray for that.
+		*/
+		class RenderQueue {
+		public:
+			struct Item {
+				Geometry *geometry;
+				PrimitivePtr primitive;
+				Material *material;
+				ShaderProgram *program;
+				unsigned int textureKey;
+				int textureArray; // index of the color map's texture array, or -1
+			};
+
+			struct Stats {
+				unsigned int drawCount;
+				unsigned int programChanges;
+				unsigned int textureChanges;
+				unsigned int bufferChanges;
+				unsigned int unsortedProgramChanges;
+				unsigned int unsortedTextureChanges;
+				unsigned int unsortedBufferChanges;
+
+				/**
+					\brief State changes avoided by sorting, negative if sorting added some
+
+					Back-to-front ordering of translucent draws can break 
+					groups that traversal order kept together.
+				*/
+				int getSavedStateChanges( void ) const
+				{
+					return ( int ) ( unsortedProgramChanges + unsortedTextureChanges + unsortedBufferChanges )
+						 - ( int ) ( programChanges + textureChanges + bufferChanges );
+				}
+			};
+
+		public:
+			RenderQueue( void );
+			virtual ~RenderQueue( void );
+
+			void clear( void );
+
+			void push( unsigned int layer, Renderer *renderer, Geometry *geometry, PrimitivePtr primitive, Material *material, Camera *camera );
+
+			void sort( void );
+
+			void foreachItem( std::function< void( Item & ) > callback );
+
+			unsigned int getItemCount( void ) const { return _order.size(); }
+
+			/**
+				\brief Returns an item in sorted order
+			*/
+			Item &getItem( unsigned int index ) { return _items[ _order[ index ] ]; }
+
+			const Stats &getStats( void ) const { return _stats; }
+
+		private:
+			uint64_t computeSortKey( unsigned int layer, const Item &item, Camera *camera );
+
+			void updateStats( void );
+
+			std::vector< Item > _items;
+			std::vector< uint64_t > _keys;
+			std::vector< unsigned int > _order;
+			std::vector< unsigned int > _scratch;
+			Stats _stats;
+		};
+
+		typedef std::shared_ptr< RenderQueue > RenderQueuePtr;
+
+	}
+
+}
+
+#endif
+
@@ -31,26 +31,79 @@
 #include "IndexBufferObjectCatalog.hpp"
 #include "FrameBufferObjectCatalog.hpp"
 #include "TextureCatalog.hpp"
+#include "SubMeshPrimitive.hpp"
+#include "Stripifier.hpp"
 #include "Library/FlatShaderProgram.hpp"
 #include "Library/GouraudShaderProgram.hpp"
+#include "Library/InstancedFlatShaderProgram.hpp"
+#include "Library/InstancedPhongShaderProgram.hpp"
+#include "Library/InstancedTextureArrayShaderProgram.hpp"
 #include "Library/ColorShaderProgram.hpp"
 #include "Library/PhongShaderProgram.hpp"
 #include "Library/ScreenShaderProgram.hpp"
 #include "Library/TextureShaderProgram.hpp"
+#include "Library/TextureArrayShaderProgram.hpp"
 #include "Utils.hpp"
 
 #include <GL/glew.h>
 #include <GL/glfw.h>
 
+#include <algorithm>
+#include <cstring>
+
 using namespace Crimild;
 
+namespace {
+
+	/*
+		Mirrors the std140 layout of each element in the 
+		uLights array declared by the LightBlock uniform block
+	*/
+	struct LightBlockEntry {
+		float position[ 4 ];
+		float attenuation[ 4 ];
+		float direction[ 4 ];
+		float color[ 4 ];
+		float outerCutoff;
+		float innerCutoff;
+		float exponent;
+		float padding;
+	};
+
+	// std140 pads uLightCount to a full vec4 before the array starts. 
+	// Used until a program reports the actual offset
+	const unsigned int LIGHT_BLOCK_LIGHTS_OFFSET = 16;
+
+	const unsigned int VERTEX_STREAM_SEGMENT_SIZE = 1024 * 1024;
+
+}
+
 GL3::Renderer::Renderer( FrameBufferObjectPtr screenBuffer )
+	: _frameNumber( 0 ),
+	  _instanceBuffer( new InstanceBuffer() ),
+	  _vertexStream( new StreamBuffer( GL_ARRAY_BUFFER, VERTEX_STREAM_SEGMENT_SIZE ) ),
+	  _instancingSupported( false ),
+	  _stateCache( new StateCache() ),
+	  _uniformCache( new UniformCache() ),
+	  _lightArrayOffset( LIGHT_BLOCK_LIGHTS_OFFSET ),
+	  _boundLightCount( 0 )
 {
-	setShaderProgramCatalog( ShaderProgramCatalogPtr( new GL3::ShaderProgramCatalog() ) );
-	setVertexBufferObjectCatalog( VertexBufferObjectCatalogPtr( new GL3::VertexBufferObjectCatalog() ) );
-	setIndexBufferObjectCatalog( IndexBufferObjectCatalogPtr( new GL3::IndexBufferObjectCatalog() ) );
+	setShaderProgramCatalog( ShaderProgramCatalogPtr( new GL3::ShaderProgramCatalog( this ) ) );
+	_vertexBufferObjectCatalog = new GL3::VertexBufferObjectCatalog( this );
+	setVertexBufferObjectCatalog( VertexBufferObjectCatalogPtr( _vertexBufferObjectCatalog ) );
+	_indexBufferObjectCatalog = new GL3::IndexBufferObjectCatalog( this );
+	setIndexBufferObjectCatalog( IndexBufferObjectCatalogPtr( _indexBufferObjectCatalog ) );
 	setFrameBufferObjectCatalog( FrameBufferObjectCatalogPtr( new GL3::FrameBufferObjectCatalog( this ) ) );
-	setTextureCatalog( TextureCatalogPtr( new GL3::TextureCatalog() ) );
+	_textureCatalog = new GL3::TextureCatalog( this );
+	setTextureCatalog( TextureCatalogPtr( _textureCatalog ) );
+
+	_uniformBuffers[ "CameraBlock" ] = UniformBufferPtr( new UniformBuffer( UniformBuffer::BindingPoint::CAMERA ) );
+	_uniformBuffers[ "LightBlock" ] = UniformBufferPtr( new UniformBuffer( UniformBuffer::BindingPoint::LIGHTS ) );
+	_lightBuffer = _uniformBuffers[ "LightBlock" ].get();
+	_lightBuffer->reserve( LIGHT_BLOCK_LIGHTS_OFFSET + MAX_LIGHTS * sizeof( LightBlockEntry ) );
+	for ( unsigned int i = 0; i < MAX_LIGHTS; i++ ) {
+		_lightSlots[ i ] = nullptr;
+	}
 
 	_fallbackPrograms[ "flat" ] = ShaderProgramPtr( new FlatShaderProgram() );
 	_fallbackPrograms[ "gouraud" ] = ShaderProgramPtr( new GouraudShaderProgram() );
@@ -58,6 +111,11 @@ GL3::Renderer::Renderer( FrameBufferObjectPtr screenBuffer )
 	_fallbackPrograms[ "color" ] = ShaderProgramPtr( new ColorShaderProgram() );
 	_fallbackPrograms[ "screen" ] = ShaderProgramPtr( new ScreenShaderProgram() );
 	_fallbackPrograms[ "texture" ] = ShaderProgramPtr( new TextureShaderProgram() );
+	_fallbackPrograms[ "textureArray" ] = ShaderProgramPtr( new TextureArrayShaderProgram() );
+
+	_instancedPrograms[ _fallbackPrograms[ "flat" ].get() ] = ShaderProgramPtr( new InstancedFlatShaderProgram() );
+	_instancedPrograms[ _fallbackPrograms[ "phong" ].get() ] = ShaderProgramPtr( new InstancedPhongShaderProgram() );
+	_instancedPrograms[ _fallbackPrograms[ "textureArray" ].get() ] = ShaderProgramPtr( new InstancedTextureArrayShaderProgram() );
 
 	setScreenBuffer( screenBuffer );
 }
@@ -89,26 +147,58 @@ void GL3::Renderer::configure( void )
 		exit( 1 );
     }
 
-    glEnable( GL_DEPTH_TEST );
-    glDepthFunc( GL_LESS );
+    // attribute divisors are core since 3.3
+    _instancingSupported = GLEW_VERSION_3_3 || GLEW_ARB_instanced_arrays;
+    if ( !_instancingSupported ) {
+    	Log::Warning << "Instanced arrays not supported. Instancing is disabled" << Log::End;
+    }
+
+    _stateCache->reset();
+    _uniformCache->reset();
+    _instanceBuffer->unload();
+    _vertexStream->unload();
+    for ( auto &arena : _bufferArenas ) {
+    	arena->unload( _stateCache.get() );
+    }
+    for ( auto &it : _uniformBuffers ) {
+    	it.second->unload();
+    }
+    _stateCache->setDepthTestEnabled( true );
+    _stateCache->setDepthFunc( GL_LESS );
 
     CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
 
 void GL3::Renderer::beginRender( void )
 {
+	++_frameNumber;
+
+	_stateCache->resetCounters();
+	_uniformCache->resetCounters();
+	for ( auto &it : _uniformBuffers ) {
+		it.second->resetCounters();
+	}
+
+	_vertexStream->resetCounters();
+	_vertexStream->beginFrame();
+
+	_textureCatalog->updateStreaming();
 
+	// lights may have moved since the last frame
+	for ( unsigned int i = 0; i < MAX_LIGHTS; i++ ) {
+		_lightSlots[ i ] = nullptr;
+	}
+	_boundLightCount = 0;
 }
 
 void GL3::Renderer::endRender( void )
 {
-
+	_vertexStream->endFrame();
 }
 
 void GL3::Renderer::clearBuffers( void )
 {
-	const RGBAColorf &clearColor = getScreenBuffer()->getClearColor();
-	glClearColor( clearColor.r(), clearColor.g(), clearColor.b(), clearColor.a() );
+	_stateCache->setClearColor( getScreenBuffer()->getClearColor() );
 	glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 }
 
@@ -117,7 +207,12 @@ void GL3::Renderer::bindUniform( ShaderLocation *location, int value )
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
 	if ( location && location->isValid() ) {
-		glUniform1i( location->getLocation(), value );
+		if ( shouldUploadUniform( location, &value, sizeof( int ) ) ) {
+			glUniform1i( location->getLocation(), value );
+		}
+	}
+	else if ( location ) {
+		bindBlockUniform( location, &value, sizeof( int ) );
 	}
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -128,7 +223,12 @@ void GL3::Renderer::bindUniform( ShaderLocation *location, float value )
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
 	if ( location && location->isValid() ) {
-		glUniform1f( location->getLocation(), value );
+		if ( shouldUploadUniform( location, &value, sizeof( float ) ) ) {
+			glUniform1f( location->getLocation(), value );
+		}
+	}
+	else if ( location ) {
+		bindBlockUniform( location, &value, sizeof( float ) );
 	}
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -139,7 +239,12 @@ void GL3::Renderer::bindUniform( ShaderLocation *location, const Vector3f &vecto
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
 	if ( location && location->isValid() ) {
-		glUniform3fv( location->getLocation(), 1, static_cast< const GLfloat * >( vector.getData() ) );
+		if ( shouldUploadUniform( location, vector.getData(), 3 * sizeof( float ) ) ) {
+			glUniform3fv( location->getLocation(), 1, static_cast< const GLfloat * >( vector.getData() ) );
+		}
+	}
+	else if ( location ) {
+		bindBlockUniform( location, vector.getData(), 3 * sizeof( float ) );
 	}
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -150,7 +255,12 @@ void GL3::Renderer::bindUniform( ShaderLocation *location, const RGBAColorf &col
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
 	if ( location && location->isValid() ) {
-		glUniform4fv( location->getLocation(), 1, static_cast< const GLfloat * >( color.getData() ) );
+		if ( shouldUploadUniform( location, color.getData(), 4 * sizeof( float ) ) ) {
+			glUniform4fv( location->getLocation(), 1, static_cast< const GLfloat * >( color.getData() ) );
+		}
+	}
+	else if ( location ) {
+		bindBlockUniform( location, color.getData(), 4 * sizeof( float ) );
 	}
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -161,58 +271,325 @@ void GL3::Renderer::bindUniform( ShaderLocation *location, const Matrix4f &matri
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
 	if ( location && location->isValid() ) {
-		glUniformMatrix4fv( location->getLocation(), 1, GL_FALSE, static_cast< const GLfloat * >( matrix.getData() ) );
+		if ( shouldUploadUniform( location, matrix.getData(), 16 * sizeof( float ) ) ) {
+			glUniformMatrix4fv( location->getLocation(), 1, GL_FALSE, static_cast< const GLfloat * >( matrix.getData() ) );
+		}
+	}
+	else if ( location ) {
+		bindBlockUniform( location, matrix.getData(), 16 * sizeof( float ) );
 	}
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
 
+bool GL3::Renderer::shouldUploadUniform( ShaderLocation *location, const void *data, unsigned int size )
+{
+	// uniforms are always set on the program currently in use
+	return _uniformCache->update( _stateCache->getProgram(), location->getLocation(), data, size );
+}
+
+GL3::UniformBuffer *GL3::Renderer::getUniformBuffer( std::string blockName )
+{
+	auto it = _uniformBuffers.find( blockName );
+	return it != _uniformBuffers.end() ? it->second.get() : nullptr;
+}
+
+void GL3::Renderer::mapBlockUniform( ShaderLocation *location, UniformBuffer *buffer, unsigned int offset )
+{
+	BlockUniform &entry = _blockUniforms[ location ];
+	entry.buffer = buffer;
+	entry.offset = offset;
+}
+
+void GL3::Renderer::setLightArrayOffset( unsigned int offset )
+{
+	if ( offset == _lightArrayOffset ) {
+		return;
+	}
+
+	_lightArrayOffset = offset;
+	_lightBuffer->reserve( _lightArrayOffset + MAX_LIGHTS * sizeof( LightBlockEntry ) );
+
+	// lights written so far are at the old offset
+	for ( unsigned int i = 0; i < MAX_LIGHTS; i++ ) {
+		_lightSlots[ i ] = nullptr;
+	}
+}
+
+void GL3::Renderer::unmapBlockUniform( ShaderLocation *location )
+{
+	_blockUniforms.erase( location );
+}
+
+void GL3::Renderer::bindBlockUniform( ShaderLocation *location, const void *data, unsigned int size )
+{
+	auto it = _blockUniforms.find( location );
+	if ( it != _blockUniforms.end() ) {
+		it->second.buffer->setData( it->second.offset, data, size );
+	}
+}
+
+bool GL3::Renderer::isBlockUniform( ShaderLocation *location, UniformBuffer *buffer )
+{
+	if ( location == nullptr ) {
+		return false;
+	}
+
+	auto it = _blockUniforms.find( location );
+	return it != _blockUniforms.end() && it->second.buffer == buffer;
+}
+
+void GL3::Renderer::bindLight( ShaderProgram *program, Light *light )
+{
+	ShaderLocation *lightCountLocation = program->getStandardLocation( ShaderProgram::StandardLocation::LIGHT_COUNT_UNIFORM );
+	if ( !isBlockUniform( lightCountLocation, _lightBuffer ) ) {
+		// program declares lights as regular uniforms
+		Crimild::Renderer::bindLight( program, light );
+		return;
+	}
+
+	if ( _boundLightCount >= MAX_LIGHTS ) {
+		return;
+	}
+
+	// every lit program shares the same block, so each light 
+	// is only written the first time it is seen during a frame
+	unsigned int index = _boundLightCount++;
+	if ( _lightSlots[ index ] != light ) {
+		_lightSlots[ index ] = light;
+		writeLight( index, light );
+	}
+
+	bindUniform( lightCountLocation, ( int ) _boundLightCount );
+}
+
+void GL3::Renderer::unbindLight( ShaderProgram *program, Light *light )
+{
+	ShaderLocation *lightCountLocation = program->getStandardLocation( ShaderProgram::StandardLocation::LIGHT_COUNT_UNIFORM );
+	if ( !isBlockUniform( lightCountLocation, _lightBuffer ) ) {
+		Crimild::Renderer::unbindLight( program, light );
+		return;
+	}
+
+	if ( _boundLightCount > 0 ) {
+		--_boundLightCount;
+	}
+}
+
+void GL3::Renderer::writeLight( unsigned int index, Light *light )
+{
+	LightBlockEntry entry;
+	memset( &entry, 0, sizeof( LightBlockEntry ) );
+	memcpy( entry.position, light->getPosition().getData(), 3 * sizeof( float ) );
+	memcpy( entry.attenuation, light->getAttenuation().getData(), 3 * sizeof( float ) );
+	memcpy( entry.direction, light->getDirection().getData(), 3 * sizeof( float ) );
+	memcpy( entry.color, light->getColor().getData(), 4 * sizeof( float ) );
+	entry.outerCutoff = light->getOuterCutoff();
+	entry.innerCutoff = light->getInnerCutoff();
+	entry.exponent = light->getExponent();
+
+	_lightBuffer->setData( _lightArrayOffset + index * sizeof( LightBlockEntry ), &entry, sizeof( LightBlockEntry ) );
+}
+
+void GL3::Renderer::commitUniformBuffers( void )
+{
+	// only the ranges modified since the last draw are uploaded, so 
+	// camera matrices end up being sent once per frame
+	for ( auto &it : _uniformBuffers ) {
+		it.second->commit();
+	}
+}
+
 void GL3::Renderer::drawPrimitive( ShaderProgram *program, Primitive *primitive )
 {
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-	GLenum type;
+	commitUniformBuffers();
+
+	unsigned int byteOffset = 0;
+	unsigned int indexCount = 0;
+	getIndexRange( primitive, byteOffset, indexCount );
+	updatePrimitiveRestart( primitive );
+
+	unsigned char *base = 0;
+	glDrawElementsBaseVertex( getPrimitiveType( primitive ),
+				   indexCount,
+				   GL_UNSIGNED_SHORT,
+				   ( GLvoid * ) ( base + byteOffset ),
+				   getBaseVertex( program, primitive ) );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+unsigned int GL3::Renderer::getPrimitiveType( Primitive *primitive )
+{
 	switch ( primitive->getType() ) {
 		case Primitive::Type::POINTS:
-			type = GL_POINTS;
-			break;
+			return GL_POINTS;
 
 		case Primitive::Type::LINES:
-			type = GL_LINES;
-			break;
+			return GL_LINES;
 			
 		case Primitive::Type::LINE_LOOP:
-			type = GL_LINE_LOOP;
-			break;
+			return GL_LINE_LOOP;
 			
 		case Primitive::Type::LINE_STRIP:
-			type = GL_LINE_STRIP;
-			break;
+			return GL_LINE_STRIP;
 			
 		case Primitive::Type::TRIANGLE_FAN:
-			type = GL_TRIANGLE_FAN;
-			break;
+			return GL_TRIANGLE_FAN;
 			
 		case Primitive::Type::TRIANGLE_STRIP:
-			type = GL_TRIANGLE_STRIP;
-			break;
+			return GL_TRIANGLE_STRIP;
 			
 		case Primitive::Type::TRIANGLES:
 		default:
-			type = GL_TRIANGLES;
-			break;
+			return GL_TRIANGLES;
+	}
+}
+
+void GL3::Renderer::updatePrimitiveRestart( Primitive *primitive )
+{
+	bool connected = primitive->getType() == Primitive::Type::TRIANGLE_STRIP 
+		|| primitive->getType() == Primitive::Type::TRIANGLE_FAN 
+		|| primitive->getType() == Primitive::Type::LINE_STRIP 
+		|| primitive->getType() == Primitive::Type::LINE_LOOP;
+
+	_stateCache->setPrimitiveRestartEnabled( connected );
+	if ( connected ) {
+		_stateCache->setPrimitiveRestartIndex( Stripifier::RESTART_INDEX );
+	}
+}
+
+void GL3::Renderer::getIndexRange( Primitive *primitive, unsigned int &byteOffset, unsigned int &indexCount )
+{
+	IndexBufferObject *ibo = primitive->getIndexBuffer();
+	unsigned int indexSize = sizeof( GLushort );
+
+	// small buffers live inside a shared pool
+	byteOffset = _indexBufferObjectCatalog->getByteOffset( ibo );
+
+	SubMeshPrimitive *subMesh = dynamic_cast< SubMeshPrimitive * >( primitive );
+	if ( subMesh != nullptr ) {
+		byteOffset += subMesh->getIndexOffset() * indexSize;
+		indexCount = subMesh->getIndexCount();
 	}
+	else {
+		indexCount = ibo->getIndexCount();
+	}
+}
+
+int GL3::Renderer::getBaseVertex( ShaderProgram *program, Primitive *primitive )
+{
+	return _vertexBufferObjectCatalog->getBaseVertex( program, primitive->getVertexBuffer() );
+}
+
+ShaderProgram *GL3::Renderer::getInstancedProgram( ShaderProgram *program )
+{
+	auto it = _instancedPrograms.find( program );
+	return it != _instancedPrograms.end() ? it->second.get() : nullptr;
+}
+
+void GL3::Renderer::drawInstancedPrimitive( ShaderProgram *program, Primitive *primitive, const float *instanceData, unsigned int instanceCount )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	commitUniformBuffers();
+
+	// the vertex array for the primitive is already bound at this point
+	_instanceBuffer->upload( instanceData, instanceCount );
+	_instanceBuffer->bindAttributes();
 
-	unsigned short *base = 0;
-	glDrawElements( type,
-				   primitive->getIndexBuffer()->getIndexCount(),
+	unsigned int byteOffset = 0;
+	unsigned int indexCount = 0;
+	getIndexRange( primitive, byteOffset, indexCount );
+	updatePrimitiveRestart( primitive );
+
+	unsigned char *base = 0;
+	glDrawElementsInstancedBaseVertex( getPrimitiveType( primitive ),
+				   indexCount,
 				   GL_UNSIGNED_SHORT,
-				   ( const GLvoid * ) base );
-	
+				   ( GLvoid * ) ( base + byteOffset ),
+				   instanceCount,
+				   getBaseVertex( program, primitive ) );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+GL3::BufferArena *GL3::Renderer::getBufferArena( const VertexFormat &format )
+{
+	for ( auto &arena : _bufferArenas ) {
+		if ( arena->getVertexFormat() == format ) {
+			return arena.get();
+		}
+	}
+
+	_bufferArenas.push_back( BufferArenaPtr( new BufferArena( format ) ) );
+	return _bufferArenas.back().get();
+}
+
+void GL3::Renderer::drawMultiPrimitive( ShaderProgram *program, std::vector< Geometry * > &geometries, std::vector< PrimitivePtr > &primitives )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	if ( primitives.empty() ) {
+		return;
+	}
+
+	commitUniformBuffers();
+
+	BufferArena *arena = getBufferArena( primitives[ 0 ]->getVertexBuffer()->getVertexFormat() );
+
+	// add everything first, since adding may compact the 
+	// arena and invalidate ranges fetched earlier
+	BufferArena::Range range;
+	for ( unsigned int i = 0; i < primitives.size(); i++ ) {
+		arena->getRange( geometries[ i ], primitives[ i ], range );
+	}
+
+	_multiDrawCounts.clear();
+	_multiDrawOffsets.clear();
+	_multiDrawBaseVertices.clear();
+	for ( unsigned int i = 0; i < primitives.size(); i++ ) {
+		if ( arena->getRange( geometries[ i ], primitives[ i ], range ) ) {
+			unsigned short *base = 0;
+			_multiDrawCounts.push_back( range.indexCount );
+			_multiDrawOffsets.push_back( base + range.firstIndex );
+			_multiDrawBaseVertices.push_back( range.baseVertex );
+		}
+	}
+
+	arena->bind( _stateCache.get() );
+
+	GLenum type = getPrimitiveType( primitives[ 0 ].get() );
+	updatePrimitiveRestart( primitives[ 0 ].get() );
+	if ( glMultiDrawElementsBaseVertex != nullptr ) {
+		glMultiDrawElementsBaseVertex( type,
+									   &_multiDrawCounts[ 0 ],
+									   GL_UNSIGNED_SHORT,
+									   &_multiDrawOffsets[ 0 ],
+									   _multiDrawCounts.size(),
+									   &_multiDrawBaseVertices[ 0 ] );
+	}
+	else {
+		for ( unsigned int i = 0; i < _multiDrawCounts.size(); i++ ) {
+			glDrawElementsBaseVertex( type, _multiDrawCounts[ i ], GL_UNSIGNED_SHORT, _multiDrawOffsets[ i ], _multiDrawBaseVertices[ i ] );
+		}
+	}
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
 
+void GL3::Renderer::bindMaterial( ShaderProgram *program, Material *material )
+{
+	Crimild::Renderer::bindMaterial( program, material );
+
+	ShaderLocation *layerLocation = program->getStandardLocation( TextureCatalog::COLOR_MAP_LAYER_UNIFORM );
+	if ( layerLocation != nullptr && layerLocation->isValid() && material->getColorMap() != nullptr ) {
+		bindUniform( layerLocation, std::max( 0, _textureCatalog->getTextureLayer( material->getColorMap() ) ) );
+	}
+}
+
 ShaderProgram *GL3::Renderer::getFallbackProgram( Material *material, Geometry *geometry, Primitive *primitive )
 {
 	if ( material == nullptr || geometry == nullptr || primitive == nullptr ) {
@@ -220,7 +597,7 @@ ShaderProgram *GL3::Renderer::getFallbackProgram( Material *material, Geometry *
 	}
 
 	if ( material->getColorMap() ) {
-		return _fallbackPrograms[ "texture" ].get();
+		return _fallbackPrograms[ _textureCatalog->usesTextureArray( material->getColorMap() ) ? "textureArray" : "texture" ].get();
 	}
 
 	if ( geometry->getComponent< RenderStateComponent >()->hasLights() ) {
@@ -237,7 +614,7 @@ ShaderProgram *GL3::Renderer::getFallbackProgram( Material *material, Geometry *
 void GL3::Renderer::setAlphaState( AlphaState *state )
 {
 	if ( state->isEnabled() ) {
-		glEnable( GL_BLEND );
+		_stateCache->setBlendEnabled( true );
 
 		GLenum srcBlendFunc = GL_SRC_ALPHA;
 		switch ( state->getSrcBlendFunc() ) {
@@ -305,20 +682,15 @@ void GL3::Renderer::setAlphaState( AlphaState *state )
 				break;
 		}
 
-		glBlendFunc( srcBlendFunc, dstBlendFunc );
+		_stateCache->setBlendFunc( srcBlendFunc, dstBlendFunc );
 	}
 	else {
-		glDisable( GL_BLEND );
+		_stateCache->setBlendEnabled( false );
 	}
 }
 
 void GL3::Renderer::setDepthState( DepthState *state )
 {
-	if ( state->isEnabled() ) {
-		glEnable( GL_DEPTH_TEST );
-	}
-	else {
-		glDisable( GL_DEPTH_TEST );
-	}
+	_stateCache->setDepthTestEnabled( state->isEnabled() );
 }
 
@@ -28,12 +28,26 @@
 #ifndef CRIMILD_GL3_RENDERER_RENDERER_
 #define CRIMILD_GL3_RENDERER_RENDERER_
 
+#include "StateCache.hpp"
+#include "UniformCache.hpp"
+#include "UniformBuffer.hpp"
+#include "InstanceBuffer.hpp"
+#include "StreamBuffer.hpp"
+#include "BufferArena.hpp"
+
 #include <Crimild.hpp>
 
+#include <unordered_map>
+#include <vector>
+
 namespace Crimild {
 
 	namespace GL3 {
 
+		class IndexBufferObjectCatalog;
+		class TextureCatalog;
+		class VertexBufferObjectCatalog;
+
 		class Renderer : public Crimild::Renderer {
 		public:
 			Renderer( FrameBufferObjectPtr screenBuffer );
@@ -54,15 +68,121 @@ namespace Crimild {
 			virtual void bindUniform( ShaderLocation *location, const RGBAColorf &color ) override;
 			virtual void bindUniform( ShaderLocation *location, const Matrix4f &matrix ) override;
 
+			virtual void bindLight( ShaderProgram *program, Light *light ) override;
+			virtual void unbindLight( ShaderProgram *program, Light *light ) override;
+
 			virtual void setDepthState( DepthState *state ) override;
 			virtual void setAlphaState( AlphaState *state ) override;
 
+			/**
+				\brief Also sets the layer of color maps stored in texture arrays
+			*/
+			virtual void bindMaterial( ShaderProgram *program, Material *material ) override;
+
 			virtual void drawPrimitive( ShaderProgram *program, Primitive *primitive ) override;
 
 			virtual ShaderProgram *getFallbackProgram( Material *material, Geometry *geometry, Primitive *primitive ) override;
 
+			bool isInstancingSupported( void ) const { return _instancingSupported; }
+
+			/**
+				\brief Returns the instanced variant of a program, or null if there is none
+			*/
+			ShaderProgram *getInstancedProgram( ShaderProgram *program );
+
+			/**
+				\brief Draws a primitive once per instance in a single call
+
+				\remarks Instance data is laid out as described in InstanceBuffer
+			*/
+			void drawInstancedPrimitive( ShaderProgram *program, Primitive *primitive, const float *instanceData, unsigned int instanceCount );
+
+			/**
+				\brief Draws several static primitives with a single submission
+
+				Primitives must share vertex format and primitive type, and 
+				each one is drawn by the geometry at the same index. They are 
+				copied into a BufferArena in world space the first time they 
+				are drawn, and the whole set is issued with one vertex array 
+				bind and one glMultiDrawElementsBaseVertex call. The model 
+				matrix must be identity.
+			*/
+			void drawMultiPrimitive( ShaderProgram *program, std::vector< Geometry * > &geometries, std::vector< PrimitivePtr > &primitives );
+
+			/**
+				\brief Number of frames started so far
+			*/
+			unsigned int getFrameNumber( void ) const { return _frameNumber; }
+
+			StateCache *getStateCache( void ) { return _stateCache.get(); }
+
+			/**
+				\brief Ring buffer used for vertex data that changes every frame
+			*/
+			StreamBuffer *getVertexStream( void ) { return _vertexStream.get(); }
+			UniformCache *getUniformCache( void ) { return _uniformCache.get(); }
+
+			/**
+				\brief Returns the buffer backing a uniform block, if any
+			*/
+			UniformBuffer *getUniformBuffer( std::string blockName );
+
+			/**
+				\brief Routes a uniform declared inside a block to its buffer
+
+				Called at link time for every location that lives in a uniform 
+				block instead of the default block.
+			*/
+			void mapBlockUniform( ShaderLocation *location, UniformBuffer *buffer, unsigned int offset );
+			void unmapBlockUniform( ShaderLocation *location );
+
+			/**
+				\brief Sets where the uLights array starts in the LightBlock buffer
+
+				Reflected at link time from programs declaring the block.
+			*/
+			void setLightArrayOffset( unsigned int offset );
+
 		private:
+			bool shouldUploadUniform( ShaderLocation *location, const void *data, unsigned int size );
+			void bindBlockUniform( ShaderLocation *location, const void *data, unsigned int size );
+			void commitUniformBuffers( void );
+			unsigned int getPrimitiveType( Primitive *primitive );
+			void updatePrimitiveRestart( Primitive *primitive );
+			void getIndexRange( Primitive *primitive, unsigned int &byteOffset, unsigned int &indexCount );
+			int getBaseVertex( ShaderProgram *program, Primitive *primitive );
+			BufferArena *getBufferArena( const VertexFormat &format );
+			bool isBlockUniform( ShaderLocation *location, UniformBuffer *buffer );
+			void writeLight( unsigned int index, Light *light );
+
+			struct BlockUniform {
+				UniformBuffer *buffer;
+				unsigned int offset;
+			};
+
+			unsigned int _frameNumber;
+			VertexBufferObjectCatalog *_vertexBufferObjectCatalog;
+			IndexBufferObjectCatalog *_indexBufferObjectCatalog;
+			TextureCatalog *_textureCatalog;
 			std::map< std::string, ShaderProgramPtr > _fallbackPrograms;
+			std::map< ShaderProgram *, ShaderProgramPtr > _instancedPrograms;
+			InstanceBufferPtr _instanceBuffer;
+			StreamBufferPtr _vertexStream;
+			bool _instancingSupported;
+			std::vector< BufferArenaPtr > _bufferArenas;
+			std::vector< int > _multiDrawCounts;
+			std::vector< void * > _multiDrawOffsets;
+			std::vector< int > _multiDrawBaseVertices;
+			StateCachePtr _stateCache;
+			UniformCachePtr _uniformCache;
+			std::map< std::string, UniformBufferPtr > _uniformBuffers;
+			std::unordered_map< ShaderLocation *, BlockUniform > _blockUniforms;
+
+			static const unsigned int MAX_LIGHTS = 4;
+			UniformBuffer *_lightBuffer;
+			unsigned int _lightArrayOffset;
+			Light *_lightSlots[ MAX_LIGHTS ];
+			unsigned int _boundLightCount;
 		};
 
 		typedef std::shared_ptr< Renderer > RendererPtr;
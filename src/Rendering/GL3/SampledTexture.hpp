@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_SAMPLED_TEXTURE_
+#define CRIMILD_GL3_SAMPLED_TEXTURE_
+
+#include "SamplerState.hpp"
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Texture with its own sampling and mipmap settings
+
+			Plain textures use the defaults set in TextureCatalog. 
+			Settings are applied when the texture is loaded.
+		*/
+		class SampledTexture : public Texture {
+		public:
+			class MipmapGeneration {
+			public:
+				enum {
+					/**
+						\brief Uses the catalog default
+					*/
+					DEFAULT,
+					NONE,
+					GPU,
+					CPU
+				};
+			};
+
+		public:
+			SampledTexture( ImagePtr image, const SamplerState &samplerState, unsigned int mipmapGeneration = MipmapGeneration::DEFAULT, std::string name = "" );
+			virtual ~SampledTexture( void );
+
+			const SamplerState &getSamplerState( void ) const { return _samplerState; }
+			void setSamplerState( const SamplerState &samplerState ) { _samplerState = samplerState; }
+
+			unsigned int getMipmapGeneration( void ) const { return _mipmapGeneration; }
+			void setMipmapGeneration( unsigned int mode ) { _mipmapGeneration = mode; }
+
+		private:
+			SamplerState _samplerState;
+			unsigned int _mipmapGeneration;
+		};
+
+		typedef std::shared_ptr< SampledTexture > SampledTexturePtr;
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SamplerState.hpp"
+
+using namespace Crimild;
+
+GL3::SamplerState::SamplerState( void )
+	: _minFilter( Filter::LINEAR_MIPMAP_LINEAR ),
+	  _magFilter( Filter::LINEAR ),
+	  _wrapS( Wrap::REPEAT ),
+	  _wrapT( Wrap::REPEAT ),
+	  _maxAnisotropy( 1.0f )
+{
+
+}
+
+GL3::SamplerState::SamplerState( unsigned int minFilter, unsigned int magFilter, unsigned int wrap, float maxAnisotropy )
+	: _minFilter( minFilter ),
+	  _magFilter( magFilter ),
+	  _wrapS( wrap ),
+	  _wrapT( wrap ),
+	  _maxAnisotropy( maxAnisotropy )
+{
+
+}
+
+GL3::SamplerState::~SamplerState( void )
+{
+
+}
+
+bool GL3::SamplerState::usesMipmaps( void ) const
+{
+	return _minFilter != Filter::NEAREST && _minFilter != Filter::LINEAR;
+}
+
+bool GL3::SamplerState::operator==( const SamplerState &other ) const
+{
+	return _minFilter == other._minFilter 
+		&& _magFilter == other._magFilter 
+		&& _wrapS == other._wrapS 
+		&& _wrapT == other._wrapT 
+		&& _maxAnisotropy == other._maxAnisotropy;
+}
+
+bool GL3::SamplerState::operator<( const SamplerState &other ) const
+{
+	if ( _minFilter != other._minFilter ) {
+		return _minFilter < other._minFilter;
+	}
+
+	if ( _magFilter != other._magFilter ) {
+		return _magFilter < other._magFilter;
+	}
+
+	if ( _wrapS != other._wrapS ) {
+		return _wrapS < other._wrapS;
+	}
+
+	if ( _wrapT != other._wrapT ) {
+		return _wrapT < other._wrapT;
+	}
+
+	return _maxAnisotropy < other._maxAnisotropy;
+}
+
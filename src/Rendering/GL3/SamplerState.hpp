@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_SAMPLER_STATE_
+#define CRIMILD_GL3_SAMPLER_STATE_
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Describes how a texture is filtered and wrapped
+
+			Defaults to trilinear filtering with repeat wrapping and
+			no anisotropy.
+		*/
+		class SamplerState {
+		public:
+			class Filter {
+			public:
+				enum {
+					NEAREST,
+					LINEAR,
+					NEAREST_MIPMAP_NEAREST,
+					LINEAR_MIPMAP_NEAREST,
+					NEAREST_MIPMAP_LINEAR,
+					LINEAR_MIPMAP_LINEAR
+				};
+			};
+
+			class Wrap {
+			public:
+				enum {
+					REPEAT,
+					MIRRORED_REPEAT,
+					CLAMP_TO_EDGE
+				};
+			};
+
+		public:
+			SamplerState( void );
+			SamplerState( unsigned int minFilter, unsigned int magFilter, unsigned int wrap = Wrap::REPEAT, float maxAnisotropy = 1.0f );
+			~SamplerState( void );
+
+			void setMinFilter( unsigned int filter ) { _minFilter = filter; }
+			unsigned int getMinFilter( void ) const { return _minFilter; }
+
+			void setMagFilter( unsigned int filter ) { _magFilter = filter; }
+			unsigned int getMagFilter( void ) const { return _magFilter; }
+
+			void setWrapS( unsigned int wrap ) { _wrapS = wrap; }
+			unsigned int getWrapS( void ) const { return _wrapS; }
+
+			void setWrapT( unsigned int wrap ) { _wrapT = wrap; }
+			unsigned int getWrapT( void ) const { return _wrapT; }
+
+			/**
+				\brief Anisotropy limit, where 1 disables anisotropic filtering
+
+				Clamped to what the driver supports when applied
+			*/
+			void setMaxAnisotropy( float value ) { _maxAnisotropy = value; }
+			float getMaxAnisotropy( void ) const { return _maxAnisotropy; }
+
+			/**
+				\brief Checks if the min filter reads mipmap levels
+			*/
+			bool usesMipmaps( void ) const;
+
+			bool operator==( const SamplerState &other ) const;
+			bool operator!=( const SamplerState &other ) const { return !( *this == other ); }
+			bool operator<( const SamplerState &other ) const;
+
+		private:
+			unsigned int _minFilter;
+			unsigned int _magFilter;
+			unsigned int _wrapS;
+			unsigned int _wrapT;
+			float _maxAnisotropy;
+		};
+
+	}
+
+}
+
+#endif
+
@@ -26,13 +26,15 @@
  */
 
 #include "ShaderProgramCatalog.hpp"
+#include "Renderer.hpp"
 #include "Utils.hpp"
 
 #include <GL/glfw.h>
 
 using namespace Crimild;
 
-GL3::ShaderProgramCatalog::ShaderProgramCatalog( void )
+GL3::ShaderProgramCatalog::ShaderProgramCatalog( Renderer *renderer )
+	: _renderer( renderer )
 {
 
 }
@@ -44,7 +46,15 @@ GL3::ShaderProgramCatalog::~ShaderProgramCatalog( void )
 
 int GL3::ShaderProgramCatalog::getNextResourceId( void )
 {
-	return glCreateProgram();
+	GpuResource resource;
+	resource.name = glCreateProgram();
+	return _resources.create( resource );
+}
+
+unsigned int GL3::ShaderProgramCatalog::getProgramName( ShaderProgram *program )
+{
+	GpuResource *resource = _resources.get( program->getCatalogId() );
+	return resource != nullptr ? resource->name : 0;
 }
 
 void GL3::ShaderProgramCatalog::bind( ShaderProgram *program )
@@ -53,7 +63,11 @@ void GL3::ShaderProgramCatalog::bind( ShaderProgram *program )
 
 	Catalog< ShaderProgram >::bind( program );
 
-	glUseProgram( program->getCatalogId() );
+	GpuResource *resource = _resources.get( program->getCatalogId() );
+	if ( resource != nullptr ) {
+		resource->lastUseFrame = getRenderer()->getFrameNumber();
+		getRenderer()->getStateCache()->useProgram( resource->name );
+	}
 
     CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
@@ -62,10 +76,10 @@ void GL3::ShaderProgramCatalog::unbind( ShaderProgram *program )
 {
     CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
+	// the program is left bound, so the state cache can skip 
+	// the next bind if it is requested again
 	Catalog< ShaderProgram >::unbind( program );
 
-	glUseProgram( 0 );
-
     CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
 
@@ -75,7 +89,7 @@ void GL3::ShaderProgramCatalog::load( ShaderProgram *program )
 
 	Catalog< ShaderProgram >::load( program );
 
-	int programId = program->getCatalogId();
+	int programId = getProgramName( program );
 	if ( programId > 0 ) {
 		int vsId = compileShader( program->getVertexShader(), GL_VERTEX_SHADER );
 		int fsId = compileShader( program->getFragmentShader(), GL_FRAGMENT_SHADER );
@@ -84,6 +98,8 @@ void GL3::ShaderProgramCatalog::load( ShaderProgram *program )
     		glAttachShader( programId, vsId );
     		glAttachShader( programId, fsId );
 
+    		bindAttributeLocations( program );
+
             glLinkProgram( programId );
 
             glDetachShader( programId, vsId );
@@ -111,6 +127,8 @@ void GL3::ShaderProgramCatalog::load( ShaderProgram *program )
                 programId = 0;
             }
 
+            bindUniformBlocks( program );
+
             program->foreachLocation( [&]( ShaderLocationPtr &loc ) mutable {
             	if ( loc->getType() == ShaderLocation::Type::ATTRIBUTE ) {
             		fetchAttributeLocation( program, loc.get() );
@@ -119,6 +137,11 @@ void GL3::ShaderProgramCatalog::load( ShaderProgram *program )
             		fetchUniformLocation( program, loc.get() );
             	}
             });
+
+            GpuResource *resource = _resources.get( program->getCatalogId() );
+            if ( resource != nullptr ) {
+            	resource->format = computeAttributeSignature( program );
+            }
         }
 	}
 
@@ -129,9 +152,17 @@ void GL3::ShaderProgramCatalog::unload( ShaderProgram *program )
 {
     CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-	int programId = program->getCatalogId();
+	int handle = program->getCatalogId();
+	int programId = getProgramName( program );
 	if ( programId > 0 ) {
+		program->foreachLocation( [&]( ShaderLocationPtr &loc ) mutable {
+			getRenderer()->unmapBlockUniform( loc.get() );
+		});
+
 		glDeleteProgram( programId );
+		getRenderer()->getStateCache()->invalidateProgram( programId );
+		getRenderer()->getUniformCache()->invalidateProgram( programId );
+		_resources.release( handle );
 	}
 
 	Catalog< ShaderProgram >::unload( program );
@@ -173,13 +204,156 @@ int GL3::ShaderProgramCatalog::compileShader( Shader *shader, int type )
     return shaderId;
 }
 
+void GL3::ShaderProgramCatalog::bindAttributeLocations( ShaderProgram *program )
+{
+	GLuint programId = getProgramName( program );
+
+	auto bindStandardLocation = [&]( unsigned int standardLocation, GLuint slot ) {
+		ShaderLocation *location = program->getStandardLocation( standardLocation );
+		if ( location != nullptr ) {
+			glBindAttribLocation( programId, slot, location->getName().c_str() );
+		}
+	};
+
+	bindStandardLocation( ShaderProgram::StandardLocation::POSITION_ATTRIBUTE, AttributeSlot::POSITION );
+	bindStandardLocation( ShaderProgram::StandardLocation::NORMAL_ATTRIBUTE, AttributeSlot::NORMAL );
+	bindStandardLocation( ShaderProgram::StandardLocation::COLOR_ATTRIBUTE, AttributeSlot::COLOR );
+	bindStandardLocation( ShaderProgram::StandardLocation::TEXTURE_COORD_ATTRIBUTE, AttributeSlot::TEXTURE_COORD );
+
+	// ignored by programs not declaring them
+	glBindAttribLocation( programId, AttributeSlot::INSTANCE_MODEL_MATRIX, "aInstanceModelMatrix" );
+	glBindAttribLocation( programId, AttributeSlot::INSTANCE_COLOR, "aInstanceColor" );
+	glBindAttribLocation( programId, AttributeSlot::INSTANCE_LAYER, "aInstanceLayer" );
+}
+
+int GL3::ShaderProgramCatalog::getAttributeLocation( unsigned int signature, unsigned int slot )
+{
+	if ( signature == 0 ) {
+		return slot;
+	}
+
+	return ( int )( ( signature >> ( 8 * slot ) ) & 0xFF ) - 1;
+}
+
+unsigned int GL3::ShaderProgramCatalog::getAttributeSignature( ShaderProgram *program )
+{
+	GpuResource *resource = _resources.get( program->getCatalogId() );
+	return resource != nullptr ? resource->format : 0;
+}
+
+bool GL3::ShaderProgramCatalog::isPositionOnly( ShaderProgram *program )
+{
+	auto isActive = [&]( unsigned int standardLocation ) {
+		ShaderLocation *location = program->getStandardLocation( standardLocation );
+		return location != nullptr && location->isValid();
+	};
+
+	return isActive( ShaderProgram::StandardLocation::POSITION_ATTRIBUTE )
+		&& !isActive( ShaderProgram::StandardLocation::NORMAL_ATTRIBUTE )
+		&& !isActive( ShaderProgram::StandardLocation::COLOR_ATTRIBUTE )
+		&& !isActive( ShaderProgram::StandardLocation::TEXTURE_COORD_ATTRIBUTE );
+}
+
+unsigned int GL3::ShaderProgramCatalog::computeAttributeSignature( ShaderProgram *program )
+{
+	unsigned int signature = 0;
+	bool canonical = true;
+
+	auto encodeStandardLocation = [&]( unsigned int standardLocation, unsigned int slot ) {
+		ShaderLocation *location = program->getStandardLocation( standardLocation );
+		int actual = ( location != nullptr && location->isValid() ) ? location->getLocation() : -1;
+		if ( actual >= 0 && actual != ( int ) slot ) {
+			canonical = false;
+		}
+		signature |= ( ( actual + 1 ) & 0xFF ) << ( 8 * slot );
+	};
+
+	encodeStandardLocation( ShaderProgram::StandardLocation::POSITION_ATTRIBUTE, AttributeSlot::POSITION );
+	encodeStandardLocation( ShaderProgram::StandardLocation::NORMAL_ATTRIBUTE, AttributeSlot::NORMAL );
+	encodeStandardLocation( ShaderProgram::StandardLocation::COLOR_ATTRIBUTE, AttributeSlot::COLOR );
+	encodeStandardLocation( ShaderProgram::StandardLocation::TEXTURE_COORD_ATTRIBUTE, AttributeSlot::TEXTURE_COORD );
+
+	// programs matching the fixed slots share the default vertex array
+	return canonical ? 0 : signature;
+}
+
 void GL3::ShaderProgramCatalog::fetchAttributeLocation( ShaderProgram *program, ShaderLocation *location )
 {
-	location->setLocation( glGetAttribLocation( program->getCatalogId(), location->getName().c_str() ) );
+	location->setLocation( glGetAttribLocation( getProgramName( program ), location->getName().c_str() ) );
 }
 
 void GL3::ShaderProgramCatalog::fetchUniformLocation( ShaderProgram *program, ShaderLocation *location )
 {
-	location->setLocation( glGetUniformLocation( program->getCatalogId(), location->getName().c_str() ) );
+	location->setLocation( glGetUniformLocation( getProgramName( program ), location->getName().c_str() ) );
+	if ( !location->isValid() ) {
+		fetchUniformBlockLocation( program, location );
+	}
+}
+
+void GL3::ShaderProgramCatalog::fetchUniformBlockLocation( ShaderProgram *program, ShaderLocation *location )
+{
+	GLuint programId = getProgramName( program );
+
+	const GLchar *name = location->getName().c_str();
+	GLuint uniformIndex = GL_INVALID_INDEX;
+	glGetUniformIndices( programId, 1, &name, &uniformIndex );
+	if ( uniformIndex == GL_INVALID_INDEX ) {
+		return;
+	}
+
+	GLint blockIndex = -1;
+	glGetActiveUniformsiv( programId, 1, &uniformIndex, GL_UNIFORM_BLOCK_INDEX, &blockIndex );
+	if ( blockIndex < 0 ) {
+		return;
+	}
+
+	GLint offset = 0;
+	glGetActiveUniformsiv( programId, 1, &uniformIndex, GL_UNIFORM_OFFSET, &offset );
+
+	GLchar blockName[ 256 ];
+	glGetActiveUniformBlockName( programId, blockIndex, sizeof( blockName ), NULL, blockName );
+
+	UniformBuffer *buffer = getRenderer()->getUniformBuffer( blockName );
+	if ( buffer != nullptr ) {
+		getRenderer()->mapBlockUniform( location, buffer, offset );
+	}
+}
+
+void GL3::ShaderProgramCatalog::bindUniformBlocks( ShaderProgram *program )
+{
+	GLuint programId = getProgramName( program );
+
+	GLint blockCount = 0;
+	glGetProgramiv( programId, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount );
+
+	for ( GLint blockIndex = 0; blockIndex < blockCount; blockIndex++ ) {
+		GLchar blockName[ 256 ];
+		glGetActiveUniformBlockName( programId, blockIndex, sizeof( blockName ), NULL, blockName );
+
+		UniformBuffer *buffer = getRenderer()->getUniformBuffer( blockName );
+		if ( buffer == nullptr ) {
+			Log::Warning << "No uniform buffer available for block " << blockName << Log::End;
+			continue;
+		}
+
+		GLint blockSize = 0;
+		glGetActiveUniformBlockiv( programId, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize );
+		buffer->reserve( blockSize );
+
+		glUniformBlockBinding( programId, blockIndex, buffer->getBindingPoint() );
+
+		if ( buffer == getRenderer()->getUniformBuffer( "LightBlock" ) ) {
+			// light entries are not standard locations, so the array 
+			// offset is reflected here instead of on location fetch
+			const GLchar *name = "uLights[0].position";
+			GLuint uniformIndex = GL_INVALID_INDEX;
+			glGetUniformIndices( programId, 1, &name, &uniformIndex );
+			if ( uniformIndex != GL_INVALID_INDEX ) {
+				GLint offset = 0;
+				glGetActiveUniformsiv( programId, 1, &uniformIndex, GL_UNIFORM_OFFSET, &offset );
+				getRenderer()->setLightArrayOffset( offset );
+			}
+		}
+	}
 }
 
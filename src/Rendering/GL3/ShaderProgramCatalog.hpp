@@ -28,17 +28,52 @@
 #ifndef CRIMILD_GL3_SHADER_PROGRAM_CATALOG_
 #define CRIMILD_GL3_SHADER_PROGRAM_CATALOG_
 
+#include "HandleTable.hpp"
+
 #include <Crimild.hpp>
 
 namespace Crimild {
 
 	namespace GL3 {
 
+		class Renderer;
+
 		class ShaderProgramCatalog : public Catalog< ShaderProgram > {
 		public:
-			ShaderProgramCatalog( void );
+			/**
+				\brief Fixed attribute indices shared by every program
+
+				Attributes are bound before linking, so a vertex array 
+				configured for one program is valid for any other.
+			*/
+			class AttributeSlot {
+			public:
+				enum {
+					POSITION = 0,
+					NORMAL = 1,
+					COLOR = 2,
+					TEXTURE_COORD = 3,
+					INSTANCE_MODEL_MATRIX = 4,
+					INSTANCE_COLOR = 8,
+					INSTANCE_LAYER = 9
+				};
+			};
+
+			/**
+				\brief Returns the location used for a standard attribute slot
+
+				A signature of zero means the program follows AttributeSlot. 
+				Otherwise each byte holds the location plus one of the 
+				attribute at that slot, or zero if the program lacks it.
+			*/
+			static int getAttributeLocation( unsigned int signature, unsigned int slot );
+
+		public:
+			ShaderProgramCatalog( Renderer *renderer );
 			virtual ~ShaderProgramCatalog( void );
 
+			Renderer *getRenderer( void ) { return _renderer; }
+
 			virtual int getNextResourceId( void ) override;
 
 			virtual void bind( ShaderProgram *program ) override;
@@ -47,11 +82,42 @@ namespace Crimild {
 			virtual void load( ShaderProgram *program ) override;
 			virtual void unload( ShaderProgram *program ) override;
 
+			/**
+				\brief Returns the GL program name for a loaded program, or zero
+			*/
+			unsigned int getProgramName( ShaderProgram *program );
+
+			/**
+				\brief Describes where a linked program reads vertex attributes from
+
+				Explicit layout qualifiers in a shader take precedence over 
+				the slots bound before linking, so programs may disagree.
+			*/
+			unsigned int getAttributeSignature( ShaderProgram *program );
+
+			/**
+				\brief Checks if a program reads no vertex attribute other than positions
+
+				Such programs, like depth or picking passes, can be fed 
+				from a position-only vertex stream.
+			*/
+			bool isPositionOnly( ShaderProgram *program );
+
+			unsigned int getResourceCount( void ) const { return _resources.getCount(); }
+
 		private:
 			int compileShader( Shader *shader, int type );
 
+			void bindAttributeLocations( ShaderProgram *program );
 			void fetchAttributeLocation( ShaderProgram *program, ShaderLocation *location );
 			void fetchUniformLocation( ShaderProgram *program, ShaderLocation *location );
+			void fetchUniformBlockLocation( ShaderProgram *program, ShaderLocation *location );
+
+			void bindUniformBlocks( ShaderProgram *program );
+			unsigned int computeAttributeSignature( ShaderProgram *program );
+
+			Renderer *_renderer;
+			GpuResourceTable _resources;
 		};
 
 		typedef std::shared_ptr< ShaderProgramCatalog > ShaderProgramCatalogPtr;
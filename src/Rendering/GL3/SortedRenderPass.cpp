@@ -0,0 +1,375 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SortedRenderPass.hpp"
+#include "Renderer.hpp"
+#include "TextureCatalog.hpp"
+#include "VertexBufferObjectCatalog.hpp"
+#include "SubMeshPrimitive.hpp"
+#include "StaticBatchComponent.hpp"
+#include "DynamicVertexBufferObject.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace Crimild;
+
+GL3::SortedRenderPass::SortedRenderPass( void )
+	: _renderQueue( new RenderQueue() ),
+	  _multiDrawEnabled( false )
+{
+
+}
+
+GL3::SortedRenderPass::~SortedRenderPass( void )
+{
+
+}
+
+void GL3::SortedRenderPass::render( Crimild::Renderer *renderer, VisibilitySet *vs, Camera *camera ) 
+{
+	_renderQueue->clear();
+
+	TextureCatalog *textureCatalog = dynamic_cast< TextureCatalog * >( renderer->getTextureCatalog() );
+	bool streaming = textureCatalog != nullptr && textureCatalog->isStreamingEnabled();
+
+	vs->foreachGeometry( [&]( Geometry *geometry ) mutable {
+		StaticBatchComponent *batch = geometry->getComponent< StaticBatchComponent >();
+		if ( batch != nullptr ) {
+			Vector3f center;
+			geometry->getWorld().applyToPoint( batch->getBound().getCenter(), center );
+			if ( isOutsideFrustum( Sphere3f( center, batch->getBound().getRadius() * geometry->getWorld().getScale() ), camera ) ) {
+				return;
+			}
+		}
+
+		RenderStateComponent *renderState = geometry->getComponent< RenderStateComponent >();
+		geometry->foreachPrimitive( [&]( PrimitivePtr &primitive ) mutable {
+			renderState->foreachMaterial( [&]( Material *material ) mutable {
+				_renderQueue->push( 0, renderer, geometry, primitive, material, camera );
+
+				if ( streaming && material->getColorMap() != nullptr ) {
+					textureCatalog->requestSize( material->getColorMap(), computeScreenSize( renderer, geometry, primitive.get(), camera ) );
+				}
+			});
+		});
+	});
+
+	_renderQueue->sort();
+
+	GL3::Renderer *gl3Renderer = dynamic_cast< GL3::Renderer * >( renderer );
+	bool instancing = gl3Renderer != nullptr && gl3Renderer->isInstancingSupported();
+
+	bool multiDraw = gl3Renderer != nullptr && _multiDrawEnabled;
+
+	unsigned int count = _renderQueue->getItemCount();
+	_submitted.assign( count, false );
+
+	unsigned int begin = 0;
+	while ( begin < count ) {
+		if ( _submitted[ begin ] ) {
+			// already drawn as part of a multi-draw bucket
+			++begin;
+			continue;
+		}
+
+		RenderQueue::Item &first = _renderQueue->getItem( begin );
+
+		unsigned int end = begin + 1;
+		if ( instancing && gl3Renderer->getInstancedProgram( first.program ) != nullptr ) {
+			while ( end < count && !_submitted[ end ] && canInstance( first, _renderQueue->getItem( end ) ) ) {
+				++end;
+			}
+		}
+
+		if ( end - begin > 1 ) {
+			renderInstanced( gl3Renderer, begin, end, camera );
+		}
+		else if ( !multiDraw || !renderMultiDraw( gl3Renderer, begin, camera ) ) {
+			RenderPass::render( renderer, first.geometry, first.primitive.get(), first.material, camera );
+		}
+
+		begin = end;
+	}
+}
+
+bool GL3::SortedRenderPass::isOutsideFrustum( const Sphere3f &bound, Camera *camera )
+{
+	Matrix4f projection = camera->getProjectionMatrix();
+	if ( projection[ 11 ] == 0.0f ) {
+		// only symmetric perspective projections are handled
+		return false;
+	}
+
+	// center in view space, looking down the negative z axis
+	Matrix4f view = camera->getViewMatrix();
+	const Vector3f &c = bound.getCenter();
+	float x = view[ 0 ] * c[ 0 ] + view[ 4 ] * c[ 1 ] + view[ 8 ] * c[ 2 ] + view[ 12 ];
+	float y = view[ 1 ] * c[ 0 ] + view[ 5 ] * c[ 1 ] + view[ 9 ] * c[ 2 ] + view[ 13 ];
+	float z = view[ 2 ] * c[ 0 ] + view[ 6 ] * c[ 1 ] + view[ 10 ] * c[ 2 ] + view[ 14 ];
+	float radius = bound.getRadius();
+
+	if ( z - radius > 0.0f ) {
+		return true;
+	}
+
+	// side planes go through the eye, with slopes given by the projection scale
+	float sx = projection[ 0 ];
+	float sy = projection[ 5 ];
+	float nx = std::sqrt( sx * sx + 1.0f );
+	float ny = std::sqrt( sy * sy + 1.0f );
+	return ( sx * x + z ) > radius * nx
+		|| ( -sx * x + z ) > radius * nx
+		|| ( sy * y + z ) > radius * ny
+		|| ( -sy * y + z ) > radius * ny;
+}
+
+float GL3::SortedRenderPass::computeScreenSize( Crimild::Renderer *renderer, Geometry *geometry, Primitive *primitive, Camera *camera )
+{
+	VertexBufferObjectCatalog *vboCatalog = dynamic_cast< VertexBufferObjectCatalog * >( renderer->getVertexBufferObjectCatalog() );
+	if ( vboCatalog == nullptr || primitive->getVertexBuffer() == nullptr ) {
+		return FLT_MAX;
+	}
+
+	float radius = vboCatalog->getBoundingRadius( primitive->getVertexBuffer() ) * geometry->getWorld().getScale();
+	Vector3f delta = geometry->getWorld().getTranslate() - camera->getWorld().getTranslate();
+	float distance = std::sqrt( delta.getSquaredMagnitude() );
+	if ( distance <= radius ) {
+		// the camera is inside the bounds, so any level may be visible
+		return FLT_MAX;
+	}
+
+	// the projection scales by the cotangent of half the field of view
+	float screenHeight = renderer->getScreenBuffer()->getHeight();
+	return screenHeight * camera->getProjectionMatrix()[ 5 ] * radius / distance;
+}
+
+bool GL3::SortedRenderPass::canInstance( RenderQueue::Item &first, RenderQueue::Item &other )
+{
+	if ( first.primitive != other.primitive || first.program != other.program ) {
+		return false;
+	}
+
+	Material *a = first.material;
+	Material *b = other.material;
+	if ( a->getColorMap() != nullptr || b->getColorMap() != nullptr ) {
+		// color maps can only vary by layer within the same texture array
+		bool sameArray = first.textureArray >= 0 && first.textureArray == other.textureArray;
+		if ( !sameArray || a->getColorMap() == nullptr || b->getColorMap() == nullptr ) {
+			return false;
+		}
+	}
+
+	if ( ( a->getAlphaState() != nullptr && a->getAlphaState()->isEnabled() ) || ( b->getAlphaState() != nullptr && b->getAlphaState()->isEnabled() ) ) {
+		// blending depends on draw order
+		return false;
+	}
+
+	bool depthA = a->getDepthState() == nullptr || a->getDepthState()->isEnabled();
+	bool depthB = b->getDepthState() == nullptr || b->getDepthState()->isEnabled();
+	if ( depthA != depthB ) {
+		return false;
+	}
+
+	// only the diffuse color is stored per instance
+	return memcmp( a->getAmbient().getData(), b->getAmbient().getData(), 4 * sizeof( float ) ) == 0
+		&& memcmp( a->getSpecular().getData(), b->getSpecular().getData(), 4 * sizeof( float ) ) == 0
+		&& a->getShininess() == b->getShininess();
+}
+
+void GL3::SortedRenderPass::renderInstanced( Renderer *renderer, unsigned int begin, unsigned int end, Camera *camera )
+{
+	RenderQueue::Item &first = _renderQueue->getItem( begin );
+	ShaderProgram *program = renderer->getInstancedProgram( first.program );
+	Material *material = first.material;
+	Geometry *geometry = first.geometry;
+	Primitive *primitive = first.primitive.get();
+
+	TextureCatalog *textureCatalog = dynamic_cast< TextureCatalog * >( renderer->getTextureCatalog() );
+
+	unsigned int instanceCount = end - begin;
+	_instanceData.resize( instanceCount * InstanceBuffer::FLOATS_PER_INSTANCE );
+	float *instance = &_instanceData[ 0 ];
+	for ( unsigned int i = begin; i < end; i++ ) {
+		RenderQueue::Item &item = _renderQueue->getItem( i );
+		Matrix4f model = item.geometry->getWorld().computeModelMatrix();
+		memcpy( instance, model.getData(), 16 * sizeof( float ) );
+		memcpy( instance + 16, item.material->getDiffuse().getData(), 4 * sizeof( float ) );
+
+		instance[ 20 ] = 0.0f;
+		if ( textureCatalog != nullptr && item.material->getColorMap() != nullptr ) {
+			instance[ 20 ] = std::max( 0, textureCatalog->getTextureLayer( item.material->getColorMap() ) );
+		}
+
+		instance += InstanceBuffer::FLOATS_PER_INSTANCE;
+	}
+
+	// lights are shared by the whole scene, so the ones 
+	// attached to the first instance apply to every other
+	RenderStateComponent *renderState = geometry->getComponent< RenderStateComponent >();
+
+	renderer->bindProgram( program );
+	renderer->bindMaterial( program, material );
+	renderState->foreachLight( [&]( Light *light ) mutable {
+		renderer->bindLight( program, light );
+	});
+	renderer->bindVertexBuffer( program, primitive->getVertexBuffer() );
+	renderer->bindIndexBuffer( program, primitive->getIndexBuffer() );
+	renderer->applyTransformations( program, geometry, camera );
+
+	renderer->drawInstancedPrimitive( program, primitive, &_instanceData[ 0 ], instanceCount );
+
+	renderer->restoreTransformations( program, geometry, camera );
+	renderer->unbindIndexBuffer( program, primitive->getIndexBuffer() );
+	renderer->unbindVertexBuffer( program, primitive->getVertexBuffer() );
+	renderState->foreachLight( [&]( Light *light ) mutable {
+		renderer->unbindLight( program, light );
+	});
+	renderer->unbindMaterial( program, material );
+	renderer->unbindProgram( program );
+}
+
+
+bool GL3::SortedRenderPass::canMultiDraw( RenderQueue::Item &first, RenderQueue::Item &other )
+{
+	if ( first.material != other.material ) {
+		return false;
+	}
+
+	VertexBufferObject *vbo = other.primitive->getVertexBuffer();
+	if ( vbo == nullptr || other.primitive->getIndexBuffer() == nullptr ) {
+		return false;
+	}
+
+	// sub-meshes already share their buffers and would duplicate 
+	// vertex data if copied into the arena one by one
+	if ( dynamic_cast< SubMeshPrimitive * >( first.primitive.get() ) != nullptr 
+		 || dynamic_cast< SubMeshPrimitive * >( other.primitive.get() ) != nullptr ) {
+		return false;
+	}
+
+	// arenas copy vertex data once, so changing buffers would go stale
+	if ( dynamic_cast< DynamicVertexBufferObject * >( first.primitive->getVertexBuffer() ) != nullptr
+		 || dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+		return false;
+	}
+
+	// arenas copy vertices in world space, which needs 3D positions
+	if ( vbo->getVertexFormat() != first.primitive->getVertexBuffer()->getVertexFormat() 
+		 || vbo->getVertexFormat().getPositionComponents() != 3
+		 || other.primitive->getType() != first.primitive->getType() ) {
+		return false;
+	}
+
+	if ( other.geometry == first.geometry ) {
+		return true;
+	}
+
+	// lights are bound once for the whole bucket
+	unsigned int lightCount = 0;
+	bool sameLights = true;
+	other.geometry->getComponent< RenderStateComponent >()->foreachLight( [&]( Light *light ) mutable {
+		sameLights = sameLights && lightCount < _multiDrawLights.size() && _multiDrawLights[ lightCount ] == light;
+		++lightCount;
+	});
+
+	return sameLights && lightCount == _multiDrawLights.size();
+}
+
+bool GL3::SortedRenderPass::renderMultiDraw( Renderer *renderer, unsigned int begin, Camera *camera )
+{
+	RenderQueue::Item &first = _renderQueue->getItem( begin );
+	Material *material = first.material;
+	if ( material->getAlphaState() != nullptr && material->getAlphaState()->isEnabled() ) {
+		// blending depends on draw order
+		return false;
+	}
+
+	if ( first.primitive->getVertexBuffer() == nullptr || first.primitive->getIndexBuffer() == nullptr 
+		 || first.primitive->getVertexBuffer()->getVertexFormat().getPositionComponents() != 3 ) {
+		return false;
+	}
+
+	ShaderProgram *program = first.program;
+	Geometry *geometry = first.geometry;
+	RenderStateComponent *renderState = geometry->getComponent< RenderStateComponent >();
+
+	_multiDrawLights.clear();
+	renderState->foreachLight( [&]( Light *light ) mutable {
+		_multiDrawLights.push_back( light );
+	});
+
+	_multiDrawGeometries.clear();
+	_multiDrawGeometries.push_back( geometry );
+	_multiDrawPrimitives.clear();
+	_multiDrawPrimitives.push_back( first.primitive );
+
+	// items sharing program and texture are contiguous in the queue
+	unsigned int count = _renderQueue->getItemCount();
+	for ( unsigned int i = begin + 1; i < count; i++ ) {
+		RenderQueue::Item &item = _renderQueue->getItem( i );
+		if ( item.program != first.program || item.material->getColorMap() != material->getColorMap() ) {
+			break;
+		}
+
+		if ( !_submitted[ i ] && canMultiDraw( first, item ) ) {
+			_multiDrawGeometries.push_back( item.geometry );
+			_multiDrawPrimitives.push_back( item.primitive );
+			_submitted[ i ] = true;
+		}
+	}
+
+	if ( _multiDrawPrimitives.size() < 2 ) {
+		return false;
+	}
+
+	renderer->bindProgram( program );
+	renderer->bindMaterial( program, material );
+	renderState->foreachLight( [&]( Light *light ) mutable {
+		renderer->bindLight( program, light );
+	});
+	renderer->applyTransformations( program, geometry, camera );
+
+	// arena vertices are already in world space
+	Matrix4f identity;
+	identity.makeIdentity();
+	renderer->bindUniform( program->getStandardLocation( ShaderProgram::StandardLocation::MODEL_MATRIX_UNIFORM ), identity );
+
+	// the arena binds its own vertex array and index buffer
+	renderer->drawMultiPrimitive( program, _multiDrawGeometries, _multiDrawPrimitives );
+
+	renderer->restoreTransformations( program, geometry, camera );
+	renderState->foreachLight( [&]( Light *light ) mutable {
+		renderer->unbindLight( program, light );
+	});
+	renderer->unbindMaterial( program, material );
+	renderer->unbindProgram( program );
+
+	return true;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_RENDER_PASS_SORTED_
+#define CRIMILD_GL3_RENDER_PASS_SORTED_
+
+#include "RenderQueue.hpp"
+
+#include <Crimild.hpp>
+
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		class Renderer;
+
+		/**
+			\brief Submits the visibility set in sort key order
+
+			Consecutive draws sharing the same primitive and program are 
+			collapsed into a single instanced draw when the renderer has 
+			an instanced variant of the program. Draws with different 
+			color maps are instanced too when the maps are layers of 
+			the same texture array.
+
+			When multi-draw is enabled, opaque draws sharing program, 
+			material and lights are gathered into buckets that go out 
+			through a single multi-draw submission, even across 
+			geometries. Vertices are copied into a BufferArena in world 
+			space, so this assumes the primitives' vertex data never 
+			changes. Geometries that move are copied again.
+
+			Geometries produced by StaticBatcher carry a bounding sphere 
+			and are skipped when it lies outside the camera's view frustum.
+
+			When texture streaming is enabled, the size on screen of each 
+			queued geometry is reported for its color map, estimated from 
+			a bounding sphere around the primitive's origin.
+
+			\see RenderQueue
+		*/
+		class SortedRenderPass : public RenderPass {
+		public:
+			SortedRenderPass( void );
+			virtual ~SortedRenderPass( void );
+
+			virtual void render( Crimild::Renderer *renderer, VisibilitySet *vs, Camera *camera ) override;
+
+			RenderQueue *getRenderQueue( void ) { return _renderQueue.get(); }
+
+			void setMultiDrawEnabled( bool value ) { _multiDrawEnabled = value; }
+			bool isMultiDrawEnabled( void ) const { return _multiDrawEnabled; }
+
+		private:
+			bool canInstance( RenderQueue::Item &first, RenderQueue::Item &other );
+			void renderInstanced( Renderer *renderer, unsigned int begin, unsigned int end, Camera *camera );
+
+			bool canMultiDraw( RenderQueue::Item &first, RenderQueue::Item &other );
+			bool renderMultiDraw( Renderer *renderer, unsigned int begin, Camera *camera );
+
+			bool isOutsideFrustum( const Sphere3f &bound, Camera *camera );
+			float computeScreenSize( Crimild::Renderer *renderer, Geometry *geometry, Primitive *primitive, Camera *camera );
+
+			RenderQueuePtr _renderQueue;
+			std::vector< bool > _submitted;
+			std::vector< float > _instanceData;
+
+			bool _multiDrawEnabled;
+			std::vector< Geometry * > _multiDrawGeometries;
+			std::vector< PrimitivePtr > _multiDrawPrimitives;
+			std::vector< Light * > _multiDrawLights;
+		};
+
+		typedef std::shared_ptr< SortedRenderPass > SortedRenderPassPtr;
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "StateCache.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+using namespace Crimild;
+
+GL3::StateCache::StateCache( void )
+	: _issuedCount( 0 ),
+	  _skippedCount( 0 )
+{
+
+}
+
+GL3::StateCache::~StateCache( void )
+{
+
+}
+
+void GL3::StateCache::reset( void )
+{
+	_depthTestEnabled.known = false;
+	_depthFunc.known = false;
+	_blendEnabled.known = false;
+	_blendSrcFunc.known = false;
+	_blendDstFunc.known = false;
+	_primitiveRestartEnabled.known = false;
+	_primitiveRestartIndex.known = false;
+	_program.known = false;
+	_vertexArray.known = false;
+	_activeTextureUnit.known = false;
+	_textureUnits.clear();
+	_frameBuffer.known = false;
+	for ( int i = 0; i < 4; i++ ) {
+		_viewport[ i ].known = false;
+		_clearColor[ i ].known = false;
+	}
+}
+
+void GL3::StateCache::resetCounters( void )
+{
+	_issuedCount = 0;
+	_skippedCount = 0;
+}
+
+template< typename T >
+bool GL3::StateCache::shouldUpdate( CachedValue< T > &cached, const T &value )
+{
+	if ( cached.known && cached.value == value ) {
+		++_skippedCount;
+		return false;
+	}
+
+	cached.known = true;
+	cached.value = value;
+	++_issuedCount;
+	return true;
+}
+
+void GL3::StateCache::setDepthTestEnabled( bool enabled )
+{
+	if ( shouldUpdate( _depthTestEnabled, enabled ) ) {
+		if ( enabled ) {
+			glEnable( GL_DEPTH_TEST );
+		}
+		else {
+			glDisable( GL_DEPTH_TEST );
+		}
+	}
+}
+
+void GL3::StateCache::setDepthFunc( unsigned int func )
+{
+	if ( shouldUpdate( _depthFunc, func ) ) {
+		glDepthFunc( func );
+	}
+}
+
+void GL3::StateCache::setBlendEnabled( bool enabled )
+{
+	if ( shouldUpdate( _blendEnabled, enabled ) ) {
+		if ( enabled ) {
+			glEnable( GL_BLEND );
+		}
+		else {
+			glDisable( GL_BLEND );
+		}
+	}
+}
+
+void GL3::StateCache::setBlendFunc( unsigned int srcFunc, unsigned int dstFunc )
+{
+	bool changed = !_blendSrcFunc.known || !_blendDstFunc.known 
+		|| _blendSrcFunc.value != srcFunc || _blendDstFunc.value != dstFunc;
+	if ( !changed ) {
+		++_skippedCount;
+		return;
+	}
+
+	_blendSrcFunc.known = _blendDstFunc.known = true;
+	_blendSrcFunc.value = srcFunc;
+	_blendDstFunc.value = dstFunc;
+	++_issuedCount;
+	glBlendFunc( srcFunc, dstFunc );
+}
+
+void GL3::StateCache::setPrimitiveRestartEnabled( bool enabled )
+{
+	if ( shouldUpdate( _primitiveRestartEnabled, enabled ) ) {
+		if ( enabled ) {
+			glEnable( GL_PRIMITIVE_RESTART );
+		}
+		else {
+			glDisable( GL_PRIMITIVE_RESTART );
+		}
+	}
+}
+
+void GL3::StateCache::setPrimitiveRestartIndex( unsigned int index )
+{
+	if ( shouldUpdate( _primitiveRestartIndex, index ) ) {
+		glPrimitiveRestartIndex( index );
+	}
+}
+
+void GL3::StateCache::useProgram( unsigned int programId )
+{
+	if ( shouldUpdate( _program, programId ) ) {
+		glUseProgram( programId );
+	}
+}
+
+void GL3::StateCache::bindVertexArray( unsigned int vaoId )
+{
+	if ( shouldUpdate( _vertexArray, vaoId ) ) {
+		glBindVertexArray( vaoId );
+	}
+}
+
+void GL3::StateCache::setActiveTextureUnit( unsigned int unit )
+{
+	if ( shouldUpdate( _activeTextureUnit, unit ) ) {
+		glActiveTexture( GL_TEXTURE0 + unit );
+	}
+}
+
+void GL3::StateCache::bindTexture( unsigned int unit, unsigned int target, unsigned int textureId )
+{
+	if ( unit >= _textureUnits.size() ) {
+		_textureUnits.resize( unit + 1 );
+	}
+
+	TextureBinding &binding = _textureUnits[ unit ];
+	bool changed = !binding.target.known || !binding.texture.known
+		|| binding.target.value != target || binding.texture.value != textureId;
+	if ( !changed ) {
+		++_skippedCount;
+		return;
+	}
+
+	setActiveTextureUnit( unit );
+
+	binding.target.known = binding.texture.known = true;
+	binding.target.value = target;
+	binding.texture.value = textureId;
+	++_issuedCount;
+	glBindTexture( target, textureId );
+}
+
+void GL3::StateCache::bindSampler( unsigned int unit, unsigned int samplerId )
+{
+	if ( unit >= _textureUnits.size() ) {
+		_textureUnits.resize( unit + 1 );
+	}
+
+	if ( shouldUpdate( _textureUnits[ unit ].sampler, samplerId ) ) {
+		glBindSampler( unit, samplerId );
+	}
+}
+
+unsigned int GL3::StateCache::getTexture( unsigned int unit ) const
+{
+	if ( unit >= _textureUnits.size() ) {
+		return 0;
+	}
+
+	return _textureUnits[ unit ].texture.value;
+}
+
+void GL3::StateCache::bindFrameBuffer( unsigned int fboId )
+{
+	if ( shouldUpdate( _frameBuffer, fboId ) ) {
+		glBindFramebuffer( GL_FRAMEBUFFER, fboId );
+	}
+}
+
+void GL3::StateCache::setViewport( int x, int y, int width, int height )
+{
+	int values[] = { x, y, width, height };
+	bool changed = false;
+	for ( int i = 0; i < 4; i++ ) {
+		changed |= !_viewport[ i ].known || _viewport[ i ].value != values[ i ];
+	}
+
+	if ( !changed ) {
+		++_skippedCount;
+		return;
+	}
+
+	for ( int i = 0; i < 4; i++ ) {
+		_viewport[ i ].known = true;
+		_viewport[ i ].value = values[ i ];
+	}
+	++_issuedCount;
+	glViewport( x, y, width, height );
+}
+
+void GL3::StateCache::setClearColor( const RGBAColorf &color )
+{
+	float values[] = { color.r(), color.g(), color.b(), color.a() };
+	bool changed = false;
+	for ( int i = 0; i < 4; i++ ) {
+		changed |= !_clearColor[ i ].known || _clearColor[ i ].value != values[ i ];
+	}
+
+	if ( !changed ) {
+		++_skippedCount;
+		return;
+	}
+
+	for ( int i = 0; i < 4; i++ ) {
+		_clearColor[ i ].known = true;
+		_clearColor[ i ].value = values[ i ];
+	}
+	++_issuedCount;
+	glClearColor( values[ 0 ], values[ 1 ], values[ 2 ], values[ 3 ] );
+}
+
+void GL3::StateCache::invalidateProgram( unsigned int programId )
+{
+	if ( _program.value == programId ) {
+		_program.known = false;
+	}
+}
+
+void GL3::StateCache::invalidateVertexArray( unsigned int vaoId )
+{
+	if ( _vertexArray.value == vaoId ) {
+		_vertexArray.known = false;
+	}
+}
+
+void GL3::StateCache::invalidateTexture( unsigned int textureId )
+{
+	for ( auto &binding : _textureUnits ) {
+		if ( binding.texture.value == textureId ) {
+			binding.texture.known = false;
+		}
+	}
+}
+
+void GL3::StateCache::invalidateFrameBuffer( unsigned int fboId )
+{
+	if ( _frameBuffer.value == fboId ) {
+		_frameBuffer.known = false;
+	}
+}
+
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_STATE_CACHE_
+#define CRIMILD_GL3_STATE_CACHE_
+
+#include <Crimild.hpp>
+
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Shadow copy of the OpenGL pipeline state
+
+			GL calls are only issued when the requested value differs
+			from the cached one. Values are unknown after reset(), so the
+			first request is always issued.
+		*/
+		class StateCache {
+		public:
+			StateCache( void );
+			virtual ~StateCache( void );
+
+			void reset( void );
+
+			void setDepthTestEnabled( bool enabled );
+			void setDepthFunc( unsigned int func );
+
+			void setBlendEnabled( bool enabled );
+			void setBlendFunc( unsigned int srcFunc, unsigned int dstFunc );
+
+			void setPrimitiveRestartEnabled( bool enabled );
+			void setPrimitiveRestartIndex( unsigned int index );
+
+			void useProgram( unsigned int programId );
+			unsigned int getProgram( void ) const { return _program.value; }
+
+			void bindVertexArray( unsigned int vaoId );
+			unsigned int getVertexArray( void ) const { return _vertexArray.value; }
+
+			void setActiveTextureUnit( unsigned int unit );
+			void bindTexture( unsigned int unit, unsigned int target, unsigned int textureId );
+			unsigned int getTexture( unsigned int unit ) const;
+
+			/**
+				\brief Binds a sampler object to a texture unit
+
+				Requires GL 3.3 or ARB_sampler_objects. Zero goes back to 
+				the parameters stored in the bound texture.
+			*/
+			void bindSampler( unsigned int unit, unsigned int samplerId );
+
+			void bindFrameBuffer( unsigned int fboId );
+			unsigned int getFrameBuffer( void ) const { return _frameBuffer.value; }
+
+			void setViewport( int x, int y, int width, int height );
+			void setClearColor( const RGBAColorf &color );
+
+			// GL unbinds deleted objects and may reuse their names
+			void invalidateProgram( unsigned int programId );
+			void invalidateVertexArray( unsigned int vaoId );
+			void invalidateTexture( unsigned int textureId );
+			void invalidateFrameBuffer( unsigned int fboId );
+
+			unsigned int getIssuedCount( void ) const { return _issuedCount; }
+			unsigned int getSkippedCount( void ) const { return _skippedCount; }
+			void resetCounters( void );
+
+		private:
+			template< typename T >
+			struct CachedValue {
+				bool known;
+				T value;
+
+				CachedValue( void ) : known( false ), value() { }
+			};
+
+			struct TextureBinding {
+				CachedValue< unsigned int > target;
+				CachedValue< unsigned int > texture;
+				CachedValue< unsigned int > sampler;
+			};
+
+			template< typename T >
+			bool shouldUpdate( CachedValue< T > &cached, const T &value );
+
+			CachedValue< bool > _depthTestEnabled;
+			CachedValue< unsigned int > _depthFunc;
+			CachedValue< bool > _blendEnabled;
+			CachedValue< unsigned int > _blendSrcFunc;
+			CachedValue< unsigned int > _blendDstFunc;
+			CachedValue< bool > _primitiveRestartEnabled;
+			CachedValue< unsigned int > _primitiveRestartIndex;
+			CachedValue< unsigned int > _program;
+			CachedValue< unsigned int > _vertexArray;
+			CachedValue< unsigned int > _activeTextureUnit;
+			std::vector< TextureBinding > _textureUnits;
+			CachedValue< unsigned int > _frameBuffer;
+			CachedValue< int > _viewport[ 4 ];
+			CachedValue< float > _clearColor[ 4 ];
+
+			unsigned int _issuedCount;
+			unsigned int _skippedCount;
+		};
+
+		typedef std::shared_ptr< StateCache > StateCachePtr;
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_STATIC_BATCH_COMPONENT_
+#define CRIMILD_GL3_STATIC_BATCH_COMPONENT_
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Describes a geometry produced by StaticBatcher
+
+			Keeps the bounding sphere of the merged chunk in the space of 
+			the batched group, since vertices are baked relative to it and 
+			the batch itself has no local transform. SortedRenderPass moves 
+			it into world space to cull batches against the camera frustum.
+		*/
+		class StaticBatchComponent : public NodeComponent {
+		public:
+			static const char *NAME;
+
+		public:
+			StaticBatchComponent( const Sphere3f &bound, unsigned int sourceCount );
+			virtual ~StaticBatchComponent( void );
+
+			const Sphere3f &getBound( void ) const { return _bound; }
+
+			unsigned int getSourceCount( void ) const { return _sourceCount; }
+
+		private:
+			Sphere3f _bound;
+			unsigned int _sourceCount;
+		};
+
+		typedef std::shared_ptr< StaticBatchComponent > StaticBatchComponentPtr;
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "StaticBatcher.hpp"
+#include "StaticBatchComponent.hpp"
+#include "SubMeshPrimitive.hpp"
+
+#include <cmath>
+
+using namespace Crimild;
+
+GL3::StaticBatcher::StaticBatcher( void )
+{
+
+}
+
+GL3::StaticBatcher::~StaticBatcher( void )
+{
+
+}
+
+GroupPtr GL3::StaticBatcher::batch( GroupPtr root, Crimild::Renderer *renderer )
+{
+	_chunks.clear();
+	_merged.clear();
+
+	root->perform( UpdateWorldState() );
+
+	// batches are attached below root, which applies its world 
+	// transform again when drawing. Vertices are baked relative to it
+	Matrix4f inverseRoot = root->getWorld().computeModelMatrix();
+	inverseRoot.makeInverse();
+	_rootInverse.fromMatrix( inverseRoot );
+
+	collect( root );
+
+	for ( auto &it : _merged ) {
+		it.first->detachNode( it.second );
+	}
+
+	GroupPtr batches( new Group( "static batches" ) );
+	for ( auto &chunk : _chunks ) {
+		if ( chunk.indices.size() > 0 ) {
+			batches->attachNode( buildGeometry( chunk, renderer ) );
+		}
+	}
+
+	root->attachNode( batches );
+
+	_chunks.clear();
+	_merged.clear();
+
+	return batches;
+}
+
+void GL3::StaticBatcher::collect( GroupPtr &group )
+{
+	group->foreachNode( [&]( NodePtr &node ) {
+		GroupPtr child = std::dynamic_pointer_cast< Group >( node );
+		if ( child != nullptr ) {
+			collect( child );
+			return;
+		}
+
+		Geometry *geometry = dynamic_cast< Geometry * >( node.get() );
+		if ( geometry != nullptr ) {
+			merge( node, geometry );
+		}
+	});
+}
+
+void GL3::StaticBatcher::merge( NodePtr &node, Geometry *geometry )
+{
+	MaterialComponent *materials = geometry->getComponent< MaterialComponent >();
+	if ( materials == nullptr || !materials->hasMaterials() ) {
+		return;
+	}
+
+	// every primitive is drawn once per material, so chunks 
+	// keyed by a single material cannot represent several
+	MaterialPtr material;
+	unsigned int materialCount = 0;
+	materials->foreachMaterial( [&]( MaterialPtr &m ) {
+		if ( material == nullptr ) {
+			material = m;
+		}
+		++materialCount;
+	});
+
+	bool mergeable = materialCount == 1;
+	geometry->foreachPrimitive( [&]( PrimitivePtr &primitive ) {
+		VertexBufferObject *vbo = primitive->getVertexBuffer();
+		IndexBufferObject *ibo = primitive->getIndexBuffer();
+		if ( primitive->getType() != Primitive::Type::TRIANGLES || vbo == nullptr || ibo == nullptr 
+			|| vbo->getVertexCount() > MAX_VERTICES_PER_CHUNK || vbo->getVertexFormat().getPositionComponents() != 3 
+			|| dynamic_cast< SubMeshPrimitive * >( primitive.get() ) != nullptr ) {
+			mergeable = false;
+		}
+	});
+
+	if ( !mergeable ) {
+		// leave the whole geometry untouched so it keeps rendering as before
+		return;
+	}
+
+	TransformationImpl relative;
+	relative.computeFrom( _rootInverse, geometry->getWorld() );
+
+	geometry->foreachPrimitive( [&]( PrimitivePtr &primitive ) {
+		VertexBufferObject *vbo = primitive->getVertexBuffer();
+		Chunk &chunk = getChunk( material, vbo->getVertexFormat(), vbo->getVertexCount() );
+		append( chunk, relative, primitive.get() );
+	});
+
+	_merged.push_back( std::make_pair( static_cast< Group * >( geometry->getParent() ), node ) );
+}
+
+GL3::StaticBatcher::Chunk &GL3::StaticBatcher::getChunk( MaterialPtr &material, const VertexFormat &format, unsigned int vertexCount )
+{
+	// search backwards, since only the last chunk of each group may have room left
+	for ( auto it = _chunks.rbegin(); it != _chunks.rend(); it++ ) {
+		if ( it->material == material && it->format == format ) {
+			unsigned int currentCount = it->vertices.size() / format.getVertexSize();
+			if ( currentCount + vertexCount <= MAX_VERTICES_PER_CHUNK ) {
+				return *it;
+			}
+			break;
+		}
+	}
+
+	_chunks.push_back( Chunk( material, format ) );
+	return _chunks.back();
+}
+
+void GL3::StaticBatcher::append( Chunk &chunk, const TransformationImpl &transform, Primitive *primitive )
+{
+	VertexBufferObject *vbo = primitive->getVertexBuffer();
+	IndexBufferObject *ibo = primitive->getIndexBuffer();
+
+	const VertexFormat &format = chunk.format;
+	unsigned int vertexSize = format.getVertexSize();
+	unsigned int vertexCount = vbo->getVertexCount();
+	unsigned int baseVertex = chunk.vertices.size() / vertexSize;
+
+	const float *src = vbo->getData();
+	chunk.vertices.insert( chunk.vertices.end(), src, src + vertexCount * vertexSize );
+
+	float *dst = &chunk.vertices[ baseVertex * vertexSize ];
+	for ( unsigned int i = 0; i < vertexCount; i++ ) {
+		float *vertex = dst + i * vertexSize;
+
+		float *p = vertex + format.getPositionsOffset();
+		Vector3f position;
+		transform.applyToPoint( Vector3f( p[ 0 ], p[ 1 ], p[ 2 ] ), position );
+		p[ 0 ] = position[ 0 ];
+		p[ 1 ] = position[ 1 ];
+		p[ 2 ] = position[ 2 ];
+
+		if ( format.hasNormals() ) {
+			float *n = vertex + format.getNormalsOffset();
+			Vector3f normal;
+			transform.applyToVector( Vector3f( n[ 0 ], n[ 1 ], n[ 2 ] ), normal );
+			if ( normal.getSquaredMagnitude() > 0.0f ) {
+				normal = normal.getNormalized();
+			}
+			n[ 0 ] = normal[ 0 ];
+			n[ 1 ] = normal[ 1 ];
+			n[ 2 ] = normal[ 2 ];
+		}
+	}
+
+	const unsigned short *indices = ibo->getData();
+	unsigned int indexCount = ibo->getIndexCount();
+	chunk.indices.reserve( chunk.indices.size() + indexCount );
+	for ( unsigned int i = 0; i < indexCount; i++ ) {
+		chunk.indices.push_back( static_cast< unsigned short >( baseVertex + indices[ i ] ) );
+	}
+
+	chunk.sourceCount++;
+}
+
+GeometryPtr GL3::StaticBatcher::buildGeometry( Chunk &chunk, Crimild::Renderer *renderer )
+{
+	const VertexFormat &format = chunk.format;
+	unsigned int vertexSize = format.getVertexSize();
+	unsigned int vertexCount = chunk.vertices.size() / vertexSize;
+
+	// bound relative to the batched root, centered at the average of all positions
+	Vector3f center( 0.0f, 0.0f, 0.0f );
+	for ( unsigned int i = 0; i < vertexCount; i++ ) {
+		const float *p = &chunk.vertices[ i * vertexSize + format.getPositionsOffset() ];
+		center = center + Vector3f( p[ 0 ], p[ 1 ], p[ 2 ] );
+	}
+	if ( vertexCount > 0 ) {
+		center = center * ( 1.0f / vertexCount );
+	}
+
+	float radiusSquared = 0.0f;
+	for ( unsigned int i = 0; i < vertexCount; i++ ) {
+		const float *p = &chunk.vertices[ i * vertexSize + format.getPositionsOffset() ];
+		float d = ( Vector3f( p[ 0 ], p[ 1 ], p[ 2 ] ) - center ).getSquaredMagnitude();
+		if ( d > radiusSquared ) {
+			radiusSquared = d;
+		}
+	}
+
+	VertexBufferObjectPtr vbo( new VertexBufferObject( format, vertexCount, &chunk.vertices[ 0 ] ) );
+	IndexBufferObjectPtr ibo( new IndexBufferObject( chunk.indices.size(), &chunk.indices[ 0 ] ) );
+
+	PrimitivePtr primitive( new Primitive( Primitive::Type::TRIANGLES ) );
+	primitive->setVertexBuffer( vbo );
+	primitive->setIndexBuffer( ibo );
+
+	GeometryPtr geometry( new Geometry( "static batch" ) );
+	geometry->attachPrimitive( primitive );
+	geometry->getComponent< MaterialComponent >()->attachMaterial( chunk.material );
+	geometry->attachComponent( StaticBatchComponentPtr( new StaticBatchComponent( Sphere3f( center, std::sqrt( radiusSquared ) ), chunk.sourceCount ) ) );
+
+	if ( renderer != nullptr ) {
+		renderer->getVertexBufferObjectCatalog()->load( vbo.get() );
+		renderer->getIndexBufferObjectCatalog()->load( ibo.get() );
+	}
+
+	// buffer objects keep their own copy of the data
+	chunk.vertices.clear();
+	chunk.indices.clear();
+
+	return geometry;
+}
+
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_STATIC_BATCHER_
+#define CRIMILD_GL3_STATIC_BATCHER_
+
+#include <Crimild.hpp>
+
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Merges immovable geometries into pre-transformed batches
+
+			Every triangle primitive found below the given group is baked 
+			into the group's space and merged with others sharing the same 
+			material and vertex format. Merged chunks are split so they
+			never exceed the range of 16-bit indices. Each chunk becomes 
+			a new Geometry tagged with a StaticBatchComponent holding its 
+			bounding sphere, and the original geometries are detached.
+
+			Geometries with more than one material, or with positions 
+			other than three components, are left untouched.
+
+			\remarks Everything below the group is assumed to never move.
+			Batching should happen before render state is computed for
+			the scene, so the new geometries receive lights.
+		*/
+		class StaticBatcher {
+		public:
+			static const unsigned int MAX_VERTICES_PER_CHUNK = 65535;
+
+		public:
+			StaticBatcher( void );
+			virtual ~StaticBatcher( void );
+
+			/**
+				\brief Batches every geometry below root
+
+				If a renderer is provided, merged buffers are loaded right
+				away into its vertex and index buffer catalogs.
+
+				\returns The group holding the merged chunks, already attached to root
+			*/
+			GroupPtr batch( GroupPtr root, Crimild::Renderer *renderer = nullptr );
+
+		private:
+			struct Chunk {
+				Chunk( MaterialPtr m, const VertexFormat &f ) : material( m ), format( f ), sourceCount( 0 ) { }
+
+				MaterialPtr material;
+				VertexFormat format;
+				std::vector< float > vertices;
+				std::vector< unsigned short > indices;
+				unsigned int sourceCount;
+			};
+
+			void collect( GroupPtr &group );
+			void merge( NodePtr &node, Geometry *geometry );
+			Chunk &getChunk( MaterialPtr &material, const VertexFormat &format, unsigned int vertexCount );
+			void append( Chunk &chunk, const TransformationImpl &transform, Primitive *primitive );
+			GeometryPtr buildGeometry( Chunk &chunk, Crimild::Renderer *renderer );
+
+			std::vector< Chunk > _chunks;
+			std::vector< std::pair< Group *, NodePtr > > _merged;
+			TransformationImpl _rootInverse;
+		};
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "StreamBuffer.hpp"
+#include "Utils.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Crimild;
+
+GL3::StreamBuffer::StreamBuffer( unsigned int target, unsigned int segmentSize )
+	: _target( target ),
+	  _bufferId( 0 ),
+	  _segmentSize( segmentSize ),
+	  _segment( 0 ),
+	  _cursor( 0 ),
+	  _generation( 0 ),
+	  _waitCount( 0 ),
+	  _bytesWritten( 0 )
+{
+	for ( unsigned int i = 0; i < SEGMENT_COUNT; i++ ) {
+		_fences[ i ] = nullptr;
+	}
+}
+
+GL3::StreamBuffer::~StreamBuffer( void )
+{
+
+}
+
+void GL3::StreamBuffer::beginFrame( void )
+{
+	_segment = ( _segment + 1 ) % SEGMENT_COUNT;
+	_cursor = 0;
+
+	waitForSegment( _segment );
+}
+
+void GL3::StreamBuffer::endFrame( void )
+{
+	if ( _bufferId == 0 || _cursor == 0 ) {
+		return;
+	}
+
+	_fences[ _segment ] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
+
+void GL3::StreamBuffer::waitForSegment( unsigned int segment )
+{
+	GLsync fence = reinterpret_cast< GLsync >( _fences[ segment ] );
+	if ( fence == nullptr ) {
+		return;
+	}
+
+	// only the first attempt avoids flushing, so the loop cannot 
+	// spin on a fence the driver has not submitted yet
+	GLbitfield flags = 0;
+	GLuint64 timeout = 0;
+	while ( true ) {
+		GLenum result = glClientWaitSync( fence, flags, timeout );
+		if ( result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED ) {
+			break;
+		}
+
+		++_waitCount;
+		flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		timeout = 1000000;
+	}
+
+	glDeleteSync( fence );
+	_fences[ segment ] = nullptr;
+}
+
+unsigned int GL3::StreamBuffer::write( const void *data, unsigned int size, unsigned int alignment )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	if ( _bufferId == 0 ) {
+		allocate( std::max( _segmentSize, size ) );
+	}
+
+	unsigned int offset = ( ( _cursor + alignment - 1 ) / alignment ) * alignment;
+	if ( offset + size > _segmentSize ) {
+		Log::Warning << "Stream buffer segment exhausted. Growing to " << 2 * std::max( _segmentSize, size ) << " bytes per segment" << Log::End;
+		allocate( 2 * std::max( _segmentSize, size ) );
+		offset = 0;
+	}
+
+	unsigned int absoluteOffset = _segment * _segmentSize + offset;
+
+	glBindBuffer( _target, _bufferId );
+	void *dst = glMapBufferRange( _target, absoluteOffset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+	if ( dst != nullptr ) {
+		memcpy( dst, data, size );
+		glUnmapBuffer( _target );
+	}
+	else {
+		glBufferSubData( _target, absoluteOffset, size, data );
+	}
+
+	_cursor = offset + size;
+	_bytesWritten += size;
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+
+	return absoluteOffset;
+}
+
+void GL3::StreamBuffer::allocate( unsigned int segmentSize )
+{
+	// the previous store is released by the driver once 
+	// draws referencing it are done, so there is no need to wait
+	deleteFences();
+
+	if ( _bufferId == 0 ) {
+		glGenBuffers( 1, &_bufferId );
+	}
+
+	_segmentSize = segmentSize;
+	_cursor = 0;
+	++_generation;
+
+	glBindBuffer( _target, _bufferId );
+	glBufferData( _target, SEGMENT_COUNT * _segmentSize, nullptr, GL_STREAM_DRAW );
+}
+
+void GL3::StreamBuffer::deleteFences( void )
+{
+	for ( unsigned int i = 0; i < SEGMENT_COUNT; i++ ) {
+		if ( _fences[ i ] != nullptr ) {
+			glDeleteSync( reinterpret_cast< GLsync >( _fences[ i ] ) );
+			_fences[ i ] = nullptr;
+		}
+	}
+}
+
+void GL3::StreamBuffer::unload( void )
+{
+	deleteFences();
+
+	if ( _bufferId > 0 ) {
+		glDeleteBuffers( 1, &_bufferId );
+		_bufferId = 0;
+	}
+
+	_cursor = 0;
+}
+
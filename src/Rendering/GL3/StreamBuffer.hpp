@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_STREAM_BUFFER_
+#define CRIMILD_GL3_STREAM_BUFFER_
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Ring buffer for data that changes every frame
+
+			The buffer is split in three segments and each frame writes 
+			into the next one. A fence is placed when a frame ends, and 
+			a segment is only reused once the GPU has signaled it, so 
+			writes can map with GL_MAP_UNSYNCHRONIZED_BIT without 
+			stalling on draws still in flight.
+
+			\remarks If a frame needs more room than a segment holds, 
+			the buffer is reallocated with twice the size. Offsets 
+			returned before that point refer to the discarded store, so 
+			callers caching them must compare getGeneration() as well.
+		*/
+		class StreamBuffer {
+		public:
+			static const unsigned int SEGMENT_COUNT = 3;
+
+		public:
+			StreamBuffer( unsigned int target, unsigned int segmentSize );
+			virtual ~StreamBuffer( void );
+
+			unsigned int getBufferId( void ) const { return _bufferId; }
+			unsigned int getSegmentSize( void ) const { return _segmentSize; }
+
+			/**
+				\brief Incremented every time the store is (re)allocated
+			*/
+			unsigned int getGeneration( void ) const { return _generation; }
+
+			void beginFrame( void );
+			void endFrame( void );
+
+			/**
+				\brief Copies data into the current segment
+
+				\returns The offset in bytes from the start of the buffer
+			*/
+			unsigned int write( const void *data, unsigned int size, unsigned int alignment = 16 );
+
+			void unload( void );
+
+			unsigned int getWaitCount( void ) const { return _waitCount; }
+			unsigned int getBytesWritten( void ) const { return _bytesWritten; }
+			void resetCounters( void ) { _waitCount = 0; _bytesWritten = 0; }
+
+		private:
+			void allocate( unsigned int segmentSize );
+			void waitForSegment( unsigned int segment );
+			void deleteFences( void );
+
+			unsigned int _target;
+			unsigned int _bufferId;
+			unsigned int _segmentSize;
+			unsigned int _segment;
+			unsigned int _cursor;
+			unsigned int _generation;
+			void *_fences[ SEGMENT_COUNT ];
+			unsigned int _waitCount;
+			unsigned int _bytesWritten;
+		};
+
+		typedef std::shared_ptr< StreamBuffer > StreamBufferPtr;
+
+	}
+
+}
+
+#endif
+
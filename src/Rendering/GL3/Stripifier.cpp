@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Stripifier.hpp"
+#include "SubMeshPrimitive.hpp"
+#include "DynamicVertexBufferObject.hpp"
+
+#include <unordered_map>
+
+using namespace Crimild;
+
+namespace {
+
+	// marks triangles taken by a finished strip, larger values are 
+	// temporary marks left while evaluating candidates
+	const unsigned int USED_TRIANGLE = 1;
+
+	unsigned int edgeKey( unsigned short a, unsigned short b )
+	{
+		return ( ( unsigned int ) a << 16 ) | b;
+	}
+
+	/**
+		\brief Triangle adjacency through directed edges
+
+		A triangle wound a, b, c owns edges ab, bc and ca. Its neighbor 
+		across ab, with consistent winding, is the one owning ba.
+	*/
+	class EdgeMap {
+	public:
+		EdgeMap( const unsigned short *indices, unsigned int triangleCount )
+			: _indices( indices )
+		{
+			_edges.reserve( triangleCount * 3 );
+			for ( unsigned int t = 0; t < triangleCount; t++ ) {
+				for ( unsigned int k = 0; k < 3; k++ ) {
+					// non-manifold edges keep their first owner
+					_edges.insert( std::make_pair( edgeKey( indices[ t * 3 + k ], indices[ t * 3 + ( k + 1 ) % 3 ] ), t ) );
+				}
+			}
+		}
+
+		/**
+			\brief Finds a triangle owning edge ab and not yet used
+
+			\returns The vertex opposite to the edge, or -1
+		*/
+		int findOpposite( unsigned short a, unsigned short b, const std::vector< unsigned int > &used, unsigned int stamp, unsigned int &triangle ) const
+		{
+			auto it = _edges.find( edgeKey( a, b ) );
+			if ( it == _edges.end() || used[ it->second ] == USED_TRIANGLE || used[ it->second ] == stamp ) {
+				return -1;
+			}
+
+			triangle = it->second;
+			for ( unsigned int k = 0; k < 3; k++ ) {
+				unsigned short v = _indices[ triangle * 3 + k ];
+				if ( v != a && v != b ) {
+					return v;
+				}
+			}
+
+			return -1;
+		}
+
+	private:
+		const unsigned short *_indices;
+		std::unordered_map< unsigned int, unsigned int > _edges;
+	};
+
+	/**
+		\brief Extends a strip starting with the given vertices
+
+		Triangles are marked in used with stamp. Only triangles marked 
+		with the same stamp, or taken by finished strips, are skipped.
+	*/
+	void growStrip( const EdgeMap &edges, std::vector< unsigned int > &used, unsigned int stamp, std::vector< unsigned short > &strip )
+	{
+		unsigned int triangle;
+		while ( true ) {
+			unsigned int n = strip.size();
+			unsigned short e0 = strip[ n - 2 ];
+			unsigned short e1 = strip[ n - 1 ];
+
+			// the next triangle is wound ( e0, e1, d ) at even positions 
+			// and ( e1, e0, d ) at odd ones, so it must own that edge
+			bool even = ( ( n - 2 ) % 2 ) == 0;
+			int d = even ? edges.findOpposite( e0, e1, used, stamp, triangle ) : edges.findOpposite( e1, e0, used, stamp, triangle );
+			if ( d < 0 ) {
+				break;
+			}
+
+			used[ triangle ] = stamp;
+			strip.push_back( d );
+		}
+	}
+
+}
+
+const unsigned short GL3::Stripifier::RESTART_INDEX;
+
+bool GL3::Stripifier::stripify( const unsigned short *indices, unsigned int indexCount, std::vector< unsigned short > &strips )
+{
+	strips.clear();
+
+	if ( indexCount == 0 || indexCount % 3 != 0 ) {
+		return false;
+	}
+
+	for ( unsigned int i = 0; i < indexCount; i++ ) {
+		if ( indices[ i ] == RESTART_INDEX ) {
+			return false;
+		}
+	}
+
+	unsigned int triangleCount = indexCount / 3;
+	EdgeMap edges( indices, triangleCount );
+
+	std::vector< unsigned int > used( triangleCount, 0 );
+	unsigned int stamp = USED_TRIANGLE;
+
+	std::vector< unsigned short > best;
+	std::vector< unsigned short > candidate;
+
+	for ( unsigned int t = 0; t < triangleCount; t++ ) {
+		if ( used[ t ] == USED_TRIANGLE ) {
+			continue;
+		}
+
+		// try every rotation of the starting triangle, keeping the longest strip
+		best.clear();
+		for ( unsigned int r = 0; r < 3; r++ ) {
+			candidate.clear();
+			candidate.push_back( indices[ t * 3 + r ] );
+			candidate.push_back( indices[ t * 3 + ( r + 1 ) % 3 ] );
+			candidate.push_back( indices[ t * 3 + ( r + 2 ) % 3 ] );
+
+			used[ t ] = ++stamp;
+			growStrip( edges, used, stamp, candidate );
+			if ( candidate.size() > best.size() ) {
+				best.swap( candidate );
+			}
+		}
+
+		// temporary marks are ignored by later candidates, so the 
+		// winner is replayed to take its triangles for good
+		used[ t ] = USED_TRIANGLE;
+		candidate.assign( best.begin(), best.begin() + 3 );
+		growStrip( edges, used, USED_TRIANGLE, candidate );
+
+		if ( !strips.empty() ) {
+			strips.push_back( RESTART_INDEX );
+		}
+		strips.insert( strips.end(), candidate.begin(), candidate.end() );
+	}
+
+	return true;
+}
+
+GL3::Stripifier::Stripifier( void )
+	: _indexCountBefore( 0 ),
+	  _indexCountAfter( 0 ),
+	  _convertedCount( 0 )
+{
+
+}
+
+GL3::Stripifier::~Stripifier( void )
+{
+
+}
+
+void GL3::Stripifier::stripify( NodePtr node )
+{
+	stripifyNode( node );
+
+	Log::Info << "Converted " << _convertedCount << " primitives to strips. "
+		<< "Indices: " << _indexCountBefore << " -> " << _indexCountAfter
+		<< Log::End;
+}
+
+void GL3::Stripifier::stripifyNode( NodePtr &node )
+{
+	GroupPtr group = std::dynamic_pointer_cast< Group >( node );
+	if ( group != nullptr ) {
+		group->foreachNode( [&]( NodePtr &child ) {
+			stripifyNode( child );
+		});
+		return;
+	}
+
+	Geometry *geometry = dynamic_cast< Geometry * >( node.get() );
+	if ( geometry == nullptr ) {
+		return;
+	}
+
+	// primitives are swapped once iteration is over
+	std::vector< std::pair< PrimitivePtr, PrimitivePtr > > replacements;
+	geometry->foreachPrimitive( [&]( PrimitivePtr &primitive ) {
+		PrimitivePtr strip = stripify( primitive.get() );
+		if ( strip != nullptr ) {
+			replacements.push_back( std::make_pair( primitive, strip ) );
+		}
+	});
+
+	for ( auto &it : replacements ) {
+		geometry->detachPrimitive( it.first );
+		geometry->attachPrimitive( it.second );
+	}
+}
+
+PrimitivePtr GL3::Stripifier::stripify( Primitive *primitive )
+{
+	VertexBufferObject *vbo = primitive->getVertexBuffer();
+	IndexBufferObject *ibo = primitive->getIndexBuffer();
+	if ( primitive->getType() != Primitive::Type::TRIANGLES || vbo == nullptr || ibo == nullptr 
+		|| dynamic_cast< SubMeshPrimitive * >( primitive ) != nullptr 
+		|| dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+		return nullptr;
+	}
+
+	std::vector< unsigned short > strips;
+	if ( !stripify( ibo->getData(), ibo->getIndexCount(), strips ) || strips.size() >= ibo->getIndexCount() ) {
+		return nullptr;
+	}
+
+	_indexCountBefore += ibo->getIndexCount();
+	_indexCountAfter += strips.size();
+	_convertedCount++;
+
+	// primitives only expose raw buffer pointers, so vertices are copied
+	PrimitivePtr strip( new Primitive( Primitive::Type::TRIANGLE_STRIP ) );
+	strip->setVertexBuffer( VertexBufferObjectPtr( new VertexBufferObject( vbo->getVertexFormat(), vbo->getVertexCount(), vbo->getData() ) ) );
+	strip->setIndexBuffer( IndexBufferObjectPtr( new IndexBufferObject( strips.size(), &strips[ 0 ] ) ) );
+
+	return strip;
+}
+
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_STRIPIFIER_
+#define CRIMILD_GL3_STRIPIFIER_
+
+#include <Crimild.hpp>
+
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Converts indexed triangle lists into triangle strips
+
+			Strips are grown greedily across shared edges, keeping the 
+			winding of the original triangles, and joined with 
+			RESTART_INDEX so the whole primitive is still drawn with a
+			single call. The renderer enables primitive restart for
+			strips using 16-bit indices.
+
+			A primitive is only replaced when the strips need fewer 
+			indices than the original list.
+
+			\remarks Meshes referencing vertex 65535 cannot be converted, 
+			since that index is reserved for restart markers.
+		*/
+		class Stripifier {
+		public:
+			static const unsigned short RESTART_INDEX = 0xFFFF;
+
+			/**
+				\brief Builds restart-separated strips for a triangle list
+
+				\returns false if the list cannot be converted
+			*/
+			static bool stripify( const unsigned short *indices, unsigned int indexCount, std::vector< unsigned short > &strips );
+
+		public:
+			Stripifier( void );
+			virtual ~Stripifier( void );
+
+			/**
+				\brief Replaces triangle lists below node with strips
+
+				Results are reported to the log once done.
+			*/
+			void stripify( NodePtr node );
+
+			/**
+				\brief Returns a strip version of a triangle list primitive
+
+				\returns null if the primitive is not worth converting
+			*/
+			PrimitivePtr stripify( Primitive *primitive );
+
+			unsigned int getIndexCountBefore( void ) const { return _indexCountBefore; }
+			unsigned int getIndexCountAfter( void ) const { return _indexCountAfter; }
+
+		private:
+			void stripifyNode( NodePtr &node );
+
+			unsigned int _indexCountBefore;
+			unsigned int _indexCountAfter;
+			unsigned int _convertedCount;
+		};
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_SUB_MESH_PRIMITIVE_
+#define CRIMILD_GL3_SUB_MESH_PRIMITIVE_
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief A primitive drawing a range of indices from shared buffers
+
+			Several sub-meshes can reference the same vertex and index 
+			buffers, each one attached to a geometry with its own material. 
+			Since catalogs work per buffer, a multi-material model ends up 
+			using a single vertex array and a single index buffer.
+		*/
+		class SubMeshPrimitive : public Primitive {
+		public:
+			SubMeshPrimitive( Primitive::Type type, VertexBufferObjectPtr vbo, IndexBufferObjectPtr ibo, unsigned int indexOffset, unsigned int indexCount );
+			virtual ~SubMeshPrimitive( void );
+
+			/**
+				\brief First index of the range, counted in indices
+			*/
+			unsigned int getIndexOffset( void ) const { return _indexOffset; }
+
+			unsigned int getIndexCount( void ) const { return _indexCount; }
+
+		private:
+			unsigned int _indexOffset;
+			unsigned int _indexCount;
+		};
+
+		typedef std::shared_ptr< SubMeshPrimitive > SubMeshPrimitivePtr;
+
+	}
+
+}
+
+#endif
+
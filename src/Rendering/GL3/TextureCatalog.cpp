@@ -26,14 +26,80 @@
  */
 
 #include "TextureCatalog.hpp"
+#include "Renderer.hpp"
 #include "Utils.hpp"
+#include "SampledTexture.hpp"
+#include "CompressedImage.hpp"
+#include "MipChain.hpp"
 
 #include <GL/glfw.h>
 
+#include <algorithm>
+
 using namespace Crimild;
 
-GL3::TextureCatalog::TextureCatalog( void )
-	: _boundTextureCount( 0 )
+namespace {
+
+	// levels up to this size are uploaded when a streamed texture is loaded
+	const unsigned int STREAMING_INITIAL_SIZE = 64;
+
+	// frames without a texture being used or sized before its target changes
+	const unsigned int STREAMING_EVICTION_DELAY = 60;
+
+	const unsigned int STREAMING_UPLOAD_LIMIT = 4 * 1024 * 1024;
+
+	const unsigned int TEXTURE_ARRAY_LAYERS = 16;
+
+	GLenum getFilter( unsigned int filter )
+	{
+		switch ( filter ) {
+			case GL3::SamplerState::Filter::NEAREST:
+				return GL_NEAREST;
+
+			case GL3::SamplerState::Filter::NEAREST_MIPMAP_NEAREST:
+				return GL_NEAREST_MIPMAP_NEAREST;
+
+			case GL3::SamplerState::Filter::LINEAR_MIPMAP_NEAREST:
+				return GL_LINEAR_MIPMAP_NEAREST;
+
+			case GL3::SamplerState::Filter::NEAREST_MIPMAP_LINEAR:
+				return GL_NEAREST_MIPMAP_LINEAR;
+
+			case GL3::SamplerState::Filter::LINEAR_MIPMAP_LINEAR:
+				return GL_LINEAR_MIPMAP_LINEAR;
+
+			case GL3::SamplerState::Filter::LINEAR:
+			default:
+				return GL_LINEAR;
+		}
+	}
+
+	GLenum getWrap( unsigned int wrap )
+	{
+		switch ( wrap ) {
+			case GL3::SamplerState::Wrap::MIRRORED_REPEAT:
+				return GL_MIRRORED_REPEAT;
+
+			case GL3::SamplerState::Wrap::CLAMP_TO_EDGE:
+				return GL_CLAMP_TO_EDGE;
+
+			case GL3::SamplerState::Wrap::REPEAT:
+			default:
+				return GL_REPEAT;
+		}
+	}
+
+}
+
+GL3::TextureCatalog::TextureCatalog( Renderer *renderer )
+	: _renderer( renderer ),
+	  _boundTextureCount( 0 ),
+	  _defaultMipmapGeneration( SampledTexture::MipmapGeneration::GPU ),
+	  _maxSupportedAnisotropy( 0.0f ),
+	  _textureArraysEnabled( false ),
+	  _streamingEnabled( false ),
+	  _memoryBudget( 0 ),
+	  _streamingUploadLimit( STREAMING_UPLOAD_LIMIT )
 {
 
 }
@@ -45,9 +111,24 @@ GL3::TextureCatalog::~TextureCatalog( void )
 
 int GL3::TextureCatalog::getNextResourceId( void )
 {
-	GLuint textureId = 0;
-	glGenTextures( 1, &textureId );
-    return textureId;
+	GpuResource resource;
+	glGenTextures( 1, &resource.name );
+	return _resources.create( resource );
+}
+
+unsigned int GL3::TextureCatalog::getTextureName( Texture *texture )
+{
+	GpuResource *resource = _resources.get( texture->getCatalogId() );
+	return resource != nullptr ? resource->name : 0;
+}
+
+int GL3::TextureCatalog::registerTexture( unsigned int textureName, unsigned int size )
+{
+	GpuResource resource;
+	resource.name = textureName;
+	resource.size = size;
+	resource.format = GL_RGBA;
+	return _resources.create( resource );
 }
 
 void GL3::TextureCatalog::bind( ShaderLocation *location, Texture *texture )
@@ -61,11 +142,20 @@ void GL3::TextureCatalog::bind( ShaderLocation *location, Texture *texture )
 	Catalog< Texture >::bind( location, texture );
 
 	if ( location && location->isValid() ) {
-		glActiveTexture( GL_TEXTURE0 + _boundTextureCount );
-		glBindTexture( GL_TEXTURE_2D, texture->getCatalogId() );
-		glUniform1i( location->getLocation(), _boundTextureCount );
+		GpuResource *resource = _resources.get( texture->getCatalogId() );
+		if ( resource != nullptr ) {
+			resource->lastUseFrame = getRenderer()->getFrameNumber();
+		}
 
-		++_boundTextureCount;
+		// units are handed out in binding order, and the state cache 
+		// skips the GL calls when a unit already holds the texture
+		unsigned int unit = _boundTextureCount++;
+		GLenum target = _arrayLayers.count( texture->getCatalogId() ) > 0 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+		getRenderer()->getStateCache()->bindTexture( unit, target, resource != nullptr ? resource->name : 0 );
+		if ( areSamplerObjectsSupported() ) {
+			getRenderer()->getStateCache()->bindSampler( unit, resource != nullptr ? resource->auxName : 0 );
+		}
+		getRenderer()->bindUniform( location, ( int ) unit );
 	} 
 
 	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -79,10 +169,10 @@ void GL3::TextureCatalog::unbind( ShaderLocation *location, Texture *texture )
 	
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-	if ( _boundTextureCount > 0 ) {
+	// textures are left bound, so the unit can be reused without 
+	// any GL call if the next draw needs the same texture
+	if ( location && location->isValid() && _boundTextureCount > 0 ) {
 		--_boundTextureCount;
-		glActiveTexture( GL_TEXTURE0 + _boundTextureCount );
-		glBindTexture( GL_TEXTURE_2D, _boundTextureCount );
 	}
 	
 	Catalog< Texture >::unbind( location, texture );
@@ -92,22 +182,601 @@ void GL3::TextureCatalog::unbind( ShaderLocation *location, Texture *texture )
 
 void GL3::TextureCatalog::load( Texture *texture )
 {
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
 	Catalog< Texture >::load( texture );
 
-	int textureId = texture->getCatalogId();
-    glBindTexture( GL_TEXTURE_2D, textureId );
-    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
-    glTexParameterf( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
-    glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 
-    	texture->getImage()->getWidth(), texture->getImage()->getHeight(), 0, 
-    	( texture->getImage()->getBpp() == 3 ? GL_RGB : GL_RGBA ), 
-    	GL_UNSIGNED_BYTE,
-        ( GLvoid * ) texture->getImage()->getData() );
+	Image *image = texture->getImage();
+	GLenum format = ( image->getBpp() == 3 ? GL_RGB : GL_RGBA );
+
+	const SamplerState &samplerState = getSamplerState( texture );
+	unsigned int mipmapGeneration = samplerState.usesMipmaps() ? getMipmapGeneration( texture ) : SampledTexture::MipmapGeneration::NONE;
+
+	GpuResource *resource = _resources.get( texture->getCatalogId() );
+	resource->size = image->getWidth() * image->getHeight() * image->getBpp();
+	resource->format = format;
+	resource->lastUseFrame = getRenderer()->getFrameNumber();
+	resource->auxName = getSamplerObject( samplerState );
+
+	if ( isTextureArrayCandidate( texture ) ) {
+		loadArrayLayer( texture, image, resource, samplerState );
+		CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+		return;
+	}
+
+	getRenderer()->getStateCache()->bindTexture( 0, GL_TEXTURE_2D, resource->name );
+	if ( resource->auxName == 0 ) {
+		applySamplerState( samplerState, GL_TEXTURE_2D );
+	}
+
+	// rows of RGB images and small mipmap levels are not word aligned
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+	CompressedImage *compressed = dynamic_cast< CompressedImage * >( image );
+	bool streamed = _streamingEnabled && samplerState.usesMipmaps() 
+		&& ( compressed == nullptr || ( compressed->getLevelCount() > 1 && isCompressedFormatSupported( compressed->getFormat() ) ) );
+
+	if ( streamed ) {
+		loadStreamed( texture, image, resource );
+	}
+	else if ( compressed != nullptr ) {
+		loadCompressed( compressed, resource, samplerState );
+	}
+	else if ( mipmapGeneration == SampledTexture::MipmapGeneration::CPU ) {
+		MipChain chain( image->getWidth(), image->getHeight(), image->getBpp(), image->getData() );
+		for ( unsigned int level = 0; level < chain.getLevelCount(); level++ ) {
+			glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA, 
+				chain.getLevelWidth( level ), chain.getLevelHeight( level ), 0, 
+				format, GL_UNSIGNED_BYTE, 
+				( GLvoid * ) chain.getLevelData( level ) );
+		}
+		glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain.getLevelCount() - 1 );
+		resource->size = chain.getTotalSize();
+	}
+	else {
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 
+			image->getWidth(), image->getHeight(), 0, 
+			format, GL_UNSIGNED_BYTE,
+			( GLvoid * ) image->getData() );
+
+		if ( mipmapGeneration == SampledTexture::MipmapGeneration::GPU ) {
+			glGenerateMipmap( GL_TEXTURE_2D );
+
+			// a full chain adds a third of the base level
+			resource->size += resource->size / 3;
+		}
+		else {
+			// keeps the texture complete even if the filter asks for mipmaps
+			glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0 );
+		}
+	}
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+bool GL3::TextureCatalog::isTextureArrayCandidate( Texture *texture )
+{
+	if ( !_textureArraysEnabled ) {
+		return false;
+	}
+
+	Image *image = texture->getImage();
+	if ( image == nullptr || dynamic_cast< CompressedImage * >( image ) != nullptr || ( image->getBpp() != 3 && image->getBpp() != 4 ) ) {
+		return false;
+	}
+
+	// streamed textures need a base level of their own
+	return !( _streamingEnabled && getSamplerState( texture ).usesMipmaps() );
+}
+
+bool GL3::TextureCatalog::usesTextureArray( Texture *texture )
+{
+	if ( _resources.get( texture->getCatalogId() ) != nullptr ) {
+		return _arrayLayers.count( texture->getCatalogId() ) > 0;
+	}
+
+	return isTextureArrayCandidate( texture );
+}
+
+int GL3::TextureCatalog::getTextureLayer( Texture *texture )
+{
+	auto it = _arrayLayers.find( texture->getCatalogId() );
+	return it != _arrayLayers.end() ? ( int ) it->second.layer : -1;
+}
+
+int GL3::TextureCatalog::getTextureArrayIndex( Texture *texture )
+{
+	auto it = _arrayLayers.find( texture->getCatalogId() );
+	return it != _arrayLayers.end() ? ( int ) it->second.array : -1;
+}
+
+GL3::TextureCatalog::TextureArray &GL3::TextureCatalog::getTextureArray( Image *image, const SamplerState &samplerState )
+{
+	for ( auto &array : _textureArrays ) {
+		if ( array.name != 0 && array.width == image->getWidth() && array.height == image->getHeight() && array.bpp == image->getBpp()
+			 && array.samplerState == samplerState && ( array.layerCount < TEXTURE_ARRAY_LAYERS || !array.freeLayers.empty() ) ) {
+			return array;
+		}
+	}
+
+	TextureArray array;
+	glGenTextures( 1, &array.name );
+	array.width = image->getWidth();
+	array.height = image->getHeight();
+	array.bpp = image->getBpp();
+	array.samplerState = samplerState;
+	array.layerCount = 0;
+	array.usedLayerCount = 0;
+
+	GLenum format = ( array.bpp == 3 ? GL_RGB : GL_RGBA );
+	unsigned int levelCount = samplerState.usesMipmaps() ? MipChain::computeLevelCount( array.width, array.height ) : 1;
+
+	getRenderer()->getStateCache()->bindTexture( 0, GL_TEXTURE_2D_ARRAY, array.name );
+	if ( !areSamplerObjectsSupported() ) {
+		applySamplerState( samplerState, GL_TEXTURE_2D_ARRAY );
+	}
+	for ( unsigned int level = 0; level < levelCount; level++ ) {
+		glTexImage3D( GL_TEXTURE_2D_ARRAY, level, GL_RGBA, 
+			std::max( 1u, array.width >> level ), std::max( 1u, array.height >> level ), TEXTURE_ARRAY_LAYERS, 0, 
+			format, GL_UNSIGNED_BYTE, nullptr );
+	}
+	glTexParameteri( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1 );
+
+	// reuse the slot of an array released before
+	for ( auto &slot : _textureArrays ) {
+		if ( slot.name == 0 ) {
+			slot = array;
+			return slot;
+		}
+	}
+
+	_textureArrays.push_back( array );
+	return _textureArrays.back();
+}
+
+void GL3::TextureCatalog::loadArrayLayer( Texture *texture, Image *image, GpuResource *resource, const SamplerState &samplerState )
+{
+	TextureArray &array = getTextureArray( image, samplerState );
+
+	unsigned int layer;
+	if ( !array.freeLayers.empty() ) {
+		layer = array.freeLayers.back();
+		array.freeLayers.pop_back();
+	}
+	else {
+		layer = array.layerCount++;
+	}
+	++array.usedLayerCount;
+
+	getRenderer()->getStateCache()->bindTexture( 0, GL_TEXTURE_2D_ARRAY, array.name );
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+	// glGenerateMipmap would rebuild every layer, so levels are built on the CPU
+	if ( samplerState.usesMipmaps() ) {
+		MipChain chain( image->getWidth(), image->getHeight(), image->getBpp(), image->getData() );
+		for ( unsigned int level = 0; level < chain.getLevelCount(); level++ ) {
+			glTexSubImage3D( GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, 
+				chain.getLevelWidth( level ), chain.getLevelHeight( level ), 1, 
+				resource->format, GL_UNSIGNED_BYTE, 
+				( GLvoid * ) chain.getLevelData( level ) );
+		}
+		resource->size = chain.getTotalSize();
+	}
+	else {
+		glTexSubImage3D( GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, 
+			image->getWidth(), image->getHeight(), 1, 
+			resource->format, GL_UNSIGNED_BYTE, 
+			( GLvoid * ) image->getData() );
+	}
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+	// the texture name created for the resource is not needed anymore
+	glDeleteTextures( 1, &resource->name );
+	resource->name = array.name;
+
+	ArrayLayer arrayLayer;
+	arrayLayer.array = &array - &_textureArrays[ 0 ];
+	arrayLayer.layer = layer;
+	_arrayLayers[ texture->getCatalogId() ] = arrayLayer;
+}
+
+void GL3::TextureCatalog::unloadArrayLayer( int handle )
+{
+	auto it = _arrayLayers.find( handle );
+	if ( it == _arrayLayers.end() ) {
+		return;
+	}
+
+	TextureArray &array = _textureArrays[ it->second.array ];
+	array.freeLayers.push_back( it->second.layer );
+	if ( --array.usedLayerCount == 0 ) {
+		glDeleteTextures( 1, &array.name );
+		getRenderer()->getStateCache()->invalidateTexture( array.name );
+		array.name = 0;
+		array.freeLayers.clear();
+	}
+
+	_arrayLayers.erase( it );
+}
+
+void GL3::TextureCatalog::loadStreamed( Texture *texture, Image *image, GpuResource *resource )
+{
+	StreamingState state;
+	state.compressed = dynamic_cast< CompressedImage * >( image );
+	if ( state.compressed != nullptr ) {
+		state.levelCount = state.compressed->getLevelCount();
+		state.maxSize = std::max( state.compressed->getLevelWidth( 0 ), state.compressed->getLevelHeight( 0 ) );
+		resource->format = state.compressed->getGLInternalFormat();
+	}
+	else {
+		state.chain = MipChainPtr( new MipChain( image->getWidth(), image->getHeight(), image->getBpp(), image->getData() ) );
+		state.levelCount = state.chain->getLevelCount();
+		state.maxSize = std::max( image->getWidth(), image->getHeight() );
+	}
+
+	state.initialLevel = 0;
+	while ( state.initialLevel + 1 < state.levelCount && ( state.maxSize >> state.initialLevel ) > STREAMING_INITIAL_SIZE ) {
+		++state.initialLevel;
+	}
+
+	state.baseLevel = state.initialLevel;
+	state.targetLevel = state.initialLevel;
+	state.requestedSize = 0.0f;
+	state.lastRequestFrame = getRenderer()->getFrameNumber();
+
+	resource->size = 0;
+	for ( unsigned int level = state.initialLevel; level < state.levelCount; level++ ) {
+		uploadLevel( state, resource, level );
+		resource->size += getLevelSize( state, level );
+	}
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, state.baseLevel );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, state.levelCount - 1 );
+
+	_streamingStates[ texture->getCatalogId() ] = state;
+}
+
+unsigned int GL3::TextureCatalog::getLevelSize( const StreamingState &state, unsigned int level )
+{
+	return state.compressed != nullptr ? state.compressed->getLevelSize( level ) : state.chain->getLevelSize( level );
+}
+
+void GL3::TextureCatalog::uploadLevel( const StreamingState &state, GpuResource *resource, unsigned int level )
+{
+	if ( state.compressed != nullptr ) {
+		glCompressedTexImage2D( GL_TEXTURE_2D, level, state.compressed->getGLInternalFormat(), 
+			state.compressed->getLevelWidth( level ), state.compressed->getLevelHeight( level ), 0, 
+			state.compressed->getLevelSize( level ), 
+			( GLvoid * ) state.compressed->getLevelData( level ) );
+	}
+	else {
+		glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA, 
+			state.chain->getLevelWidth( level ), state.chain->getLevelHeight( level ), 0, 
+			resource->format, GL_UNSIGNED_BYTE, 
+			( GLvoid * ) state.chain->getLevelData( level ) );
+	}
+}
+
+void GL3::TextureCatalog::streamIn( StreamingState &state, GpuResource *resource )
+{
+	unsigned int level = state.baseLevel - 1;
+
+	getRenderer()->getStateCache()->bindTexture( 0, GL_TEXTURE_2D, resource->name );
+	uploadLevel( state, resource, level );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level );
+
+	state.baseLevel = level;
+	resource->size += getLevelSize( state, level );
+}
+
+void GL3::TextureCatalog::evict( StreamingState &state, GpuResource *resource )
+{
+	unsigned int level = state.baseLevel;
+
+	getRenderer()->getStateCache()->bindTexture( 0, GL_TEXTURE_2D, resource->name );
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1 );
+
+	// redefining the level as an empty image releases its storage
+	if ( state.compressed != nullptr ) {
+		glCompressedTexImage2D( GL_TEXTURE_2D, level, state.compressed->getGLInternalFormat(), 0, 0, 0, 0, nullptr );
+	}
+	else {
+		glTexImage2D( GL_TEXTURE_2D, level, GL_RGBA, 0, 0, 0, resource->format, GL_UNSIGNED_BYTE, nullptr );
+	}
+
+	state.baseLevel = level + 1;
+	resource->size -= getLevelSize( state, level );
+}
+
+unsigned int GL3::TextureCatalog::computeTargetLevel( StreamingState &state, GpuResource *resource )
+{
+	unsigned int frame = getRenderer()->getFrameNumber();
+	unsigned int target = state.targetLevel;
+
+	if ( state.requestedSize > 0.0f ) {
+		// one texel per pixel, never coarser than the levels loaded initially
+		float ratio = state.maxSize / state.requestedSize;
+		target = 0;
+		while ( ratio >= 2.0f && target < state.initialLevel ) {
+			ratio *= 0.5f;
+			++target;
+		}
+	}
+	else if ( frame - resource->lastUseFrame > STREAMING_EVICTION_DELAY ) {
+		target = state.initialLevel;
+	}
+	else if ( frame - state.lastRequestFrame > STREAMING_EVICTION_DELAY ) {
+		// still in use, but nothing reports how large it looks
+		target = 0;
+	}
+
+	state.requestedSize = 0.0f;
+	return target;
+}
+
+void GL3::TextureCatalog::requestSize( Texture *texture, float screenSize )
+{
+	auto it = _streamingStates.find( texture->getCatalogId() );
+	if ( it != _streamingStates.end() ) {
+		it->second.requestedSize = std::max( it->second.requestedSize, screenSize );
+		it->second.lastRequestFrame = getRenderer()->getFrameNumber();
+	}
+}
+
+void GL3::TextureCatalog::updateStreaming( void )
+{
+	if ( _streamingStates.empty() ) {
+		return;
+	}
+
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+	// dropping levels no longer needed first makes room for the rest
+	_streamingQueue.clear();
+	for ( auto &it : _streamingStates ) {
+		StreamingState &state = it.second;
+		GpuResource *resource = _resources.get( it.first );
+		if ( resource == nullptr ) {
+			continue;
+		}
+
+		state.targetLevel = computeTargetLevel( state, resource );
+		while ( state.baseLevel < state.targetLevel ) {
+			evict( state, resource );
+		}
+
+		if ( state.baseLevel > state.targetLevel ) {
+			_streamingQueue.push_back( it.first );
+		}
+	}
+
+	unsigned int residentSize = getResidentSize();
+	while ( _memoryBudget > 0 && residentSize > _memoryBudget ) {
+		if ( !evictLeastRecentlyUsed( ~0u, residentSize ) ) {
+			break;
+		}
+	}
+
+	// textures used most recently and furthest from their target go first
+	std::sort( _streamingQueue.begin(), _streamingQueue.end(), [&]( int a, int b ) {
+		unsigned int frameA = _resources.get( a )->lastUseFrame;
+		unsigned int frameB = _resources.get( b )->lastUseFrame;
+		if ( frameA != frameB ) {
+			return frameA > frameB;
+		}
+
+		const StreamingState &stateA = _streamingStates[ a ];
+		const StreamingState &stateB = _streamingStates[ b ];
+		return stateA.baseLevel - stateA.targetLevel > stateB.baseLevel - stateB.targetLevel;
+	});
+
+	unsigned int uploadedSize = 0;
+	for ( int handle : _streamingQueue ) {
+		if ( uploadedSize >= _streamingUploadLimit ) {
+			break;
+		}
+
+		StreamingState &state = _streamingStates[ handle ];
+		GpuResource *resource = _resources.get( handle );
+		unsigned int size = getLevelSize( state, state.baseLevel - 1 );
+
+		// make room by taking levels from textures idle for longer
+		while ( _memoryBudget > 0 && residentSize + size > _memoryBudget ) {
+			if ( !evictLeastRecentlyUsed( resource->lastUseFrame, residentSize ) ) {
+				break;
+			}
+		}
+
+		if ( _memoryBudget > 0 && residentSize + size > _memoryBudget ) {
+			continue;
+		}
+
+		streamIn( state, resource );
+		uploadedSize += size;
+		residentSize += size;
+	}
+
+	glPixelStorei( GL_UNPACK_ALIGNMENT, 4 );
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+bool GL3::TextureCatalog::evictLeastRecentlyUsed( unsigned int usedBefore, unsigned int &residentSize )
+{
+	// least recently used textures lose their finest level first
+	StreamingState *victim = nullptr;
+	GpuResource *victimResource = nullptr;
+	for ( auto &it : _streamingStates ) {
+		GpuResource *resource = _resources.get( it.first );
+		if ( resource != nullptr && it.second.baseLevel < it.second.initialLevel && resource->lastUseFrame < usedBefore
+			 && ( victim == nullptr || resource->lastUseFrame < victimResource->lastUseFrame ) ) {
+			victim = &it.second;
+			victimResource = resource;
+		}
+	}
+
+	if ( victim == nullptr ) {
+		return false;
+	}
+
+	residentSize -= getLevelSize( *victim, victim->baseLevel );
+	evict( *victim, victimResource );
+	return true;
+}
+
+unsigned int GL3::TextureCatalog::getResidentLevel( Texture *texture )
+{
+	auto it = _streamingStates.find( texture->getCatalogId() );
+	return it != _streamingStates.end() ? it->second.baseLevel : 0;
+}
+
+unsigned int GL3::TextureCatalog::getResidentSize( void )
+{
+	unsigned int size = 0;
+	_resources.foreach( [&]( GpuResource &resource ) {
+		size += resource.size;
+	});
+
+	return size;
+}
+
+bool GL3::TextureCatalog::isCompressedFormatSupported( unsigned int format ) const
+{
+	switch ( format ) {
+		case CompressedImage::Format::BC1:
+		case CompressedImage::Format::BC1_ALPHA:
+		case CompressedImage::Format::BC2:
+		case CompressedImage::Format::BC3:
+			return GLEW_EXT_texture_compression_s3tc;
+
+		case CompressedImage::Format::BC4:
+		case CompressedImage::Format::BC5:
+			// RGTC is core since GL 3.0
+			return true;
+
+		case CompressedImage::Format::BC7:
+			return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+
+		case CompressedImage::Format::ETC2_RGB:
+		case CompressedImage::Format::ETC2_RGBA:
+			return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+
+		default:
+			return false;
+	}
+}
+
+void GL3::TextureCatalog::loadCompressed( CompressedImage *image, GpuResource *resource, const SamplerState &samplerState )
+{
+	resource->format = image->getGLInternalFormat();
+
+	if ( !isCompressedFormatSupported( image->getFormat() ) || image->getLevelCount() == 0 ) {
+		Log::Error << "Compressed texture format not supported by this context" << Log::End;
+		resource->size = 0;
+		return;
+	}
+
+	// blocks cannot be filtered by glGenerateMipmap, so only the levels
+	// stored in the image are used
+	unsigned int levelCount = samplerState.usesMipmaps() ? image->getLevelCount() : 1;
+	for ( unsigned int level = 0; level < levelCount; level++ ) {
+		glCompressedTexImage2D( GL_TEXTURE_2D, level, image->getGLInternalFormat(), 
+			image->getLevelWidth( level ), image->getLevelHeight( level ), 0, 
+			image->getLevelSize( level ), 
+			( GLvoid * ) image->getLevelData( level ) );
+	}
+	glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1 );
+
+	resource->size = image->getTotalSize() - image->getTotalSize( levelCount );
+}
+
+const GL3::SamplerState &GL3::TextureCatalog::getSamplerState( Texture *texture )
+{
+	SampledTexture *sampled = dynamic_cast< SampledTexture * >( texture );
+	return sampled != nullptr ? sampled->getSamplerState() : _defaultSamplerState;
+}
+
+unsigned int GL3::TextureCatalog::getMipmapGeneration( Texture *texture )
+{
+	SampledTexture *sampled = dynamic_cast< SampledTexture * >( texture );
+	if ( sampled != nullptr && sampled->getMipmapGeneration() != SampledTexture::MipmapGeneration::DEFAULT ) {
+		return sampled->getMipmapGeneration();
+	}
+
+	return _defaultMipmapGeneration;
+}
+
+bool GL3::TextureCatalog::areSamplerObjectsSupported( void ) const
+{
+	return GLEW_VERSION_3_3 || GLEW_ARB_sampler_objects;
+}
+
+unsigned int GL3::TextureCatalog::getSamplerObject( const SamplerState &samplerState )
+{
+	if ( !areSamplerObjectsSupported() ) {
+		return 0;
+	}
+
+	auto it = _samplerObjects.find( samplerState );
+	if ( it != _samplerObjects.end() ) {
+		return it->second;
+	}
+
+	GLuint samplerId = 0;
+	glGenSamplers( 1, &samplerId );
+	glSamplerParameteri( samplerId, GL_TEXTURE_MIN_FILTER, getFilter( samplerState.getMinFilter() ) );
+	glSamplerParameteri( samplerId, GL_TEXTURE_MAG_FILTER, getFilter( samplerState.getMagFilter() ) == GL_NEAREST ? GL_NEAREST : GL_LINEAR );
+	glSamplerParameteri( samplerId, GL_TEXTURE_WRAP_S, getWrap( samplerState.getWrapS() ) );
+	glSamplerParameteri( samplerId, GL_TEXTURE_WRAP_T, getWrap( samplerState.getWrapT() ) );
+	if ( GLEW_EXT_texture_filter_anisotropic ) {
+		glSamplerParameterf( samplerId, GL_TEXTURE_MAX_ANISOTROPY_EXT, getAnisotropy( samplerState ) );
+	}
+
+	_samplerObjects[ samplerState ] = samplerId;
+	return samplerId;
+}
+
+float GL3::TextureCatalog::getAnisotropy( const SamplerState &samplerState )
+{
+	if ( _maxSupportedAnisotropy == 0.0f ) {
+		glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &_maxSupportedAnisotropy );
+	}
+
+	return std::max( 1.0f, std::min( samplerState.getMaxAnisotropy(), _maxSupportedAnisotropy ) );
+}
+
+void GL3::TextureCatalog::applySamplerState( const SamplerState &samplerState, unsigned int target )
+{
+	glTexParameteri( target, GL_TEXTURE_MIN_FILTER, getFilter( samplerState.getMinFilter() ) );
+	glTexParameteri( target, GL_TEXTURE_MAG_FILTER, getFilter( samplerState.getMagFilter() ) == GL_NEAREST ? GL_NEAREST : GL_LINEAR );
+	glTexParameteri( target, GL_TEXTURE_WRAP_S, getWrap( samplerState.getWrapS() ) );
+	glTexParameteri( target, GL_TEXTURE_WRAP_T, getWrap( samplerState.getWrapT() ) );
+
+	if ( GLEW_EXT_texture_filter_anisotropic ) {
+		glTexParameterf( target, GL_TEXTURE_MAX_ANISOTROPY_EXT, getAnisotropy( samplerState ) );
+	}
 }
 
 void GL3::TextureCatalog::unload( Texture *texture )
 {
-	glBindTexture( GL_TEXTURE_2D, 0 );
+	int handle = texture->getCatalogId();
+	GpuResource *resource = _resources.get( handle );
+	if ( resource != nullptr ) {
+		if ( _arrayLayers.count( handle ) > 0 ) {
+			// the array is deleted along with its last layer
+			unloadArrayLayer( handle );
+		}
+		else {
+			glDeleteTextures( 1, &resource->name );
+			getRenderer()->getStateCache()->invalidateTexture( resource->name );
+		}
+		_resources.release( handle );
+	}
+	_streamingStates.erase( handle );
 
 	Catalog< Texture >::unload( texture );
 }
@@ -28,17 +28,39 @@
 #ifndef CRIMILD_GL3_TEXTURE_CATALOG_
 #define CRIMILD_GL3_TEXTURE_CATALOG_
 
+#include "HandleTable.hpp"
+#include "MipChain.hpp"
+#include "SamplerState.hpp"
+
 #include <Crimild.hpp>
 
+#include <map>
+#include <vector>
+
 namespace Crimild {
 
 	namespace GL3 {
 
+		class CompressedImage;
+		class Renderer;
+
 		class TextureCatalog : public Catalog< Texture > {
 		public:
-			TextureCatalog( void );
+			/**
+				\brief Standard location for the layer of a color map stored in a texture array
+
+				Programs sampling uColorMap as a sampler2DArray register 
+				their layer uniform with this id, and the renderer sets it 
+				when binding a material.
+			*/
+			static const unsigned int COLOR_MAP_LAYER_UNIFORM = 2000;
+
+		public:
+			TextureCatalog( Renderer *renderer );
 			virtual ~TextureCatalog( void );
 
+			Renderer *getRenderer( void ) { return _renderer; }
+
 			virtual int getNextResourceId( void ) override;
 
 			virtual void bind( ShaderLocation *location, Texture *texture ) override;
@@ -47,8 +69,205 @@ namespace Crimild {
 			virtual void load( Texture *texture ) override;
 			virtual void unload( Texture *texture ) override;
 
+			/**
+				\brief Returns the GL texture name for a loaded texture, or zero
+			*/
+			unsigned int getTextureName( Texture *texture );
+
+			/**
+				\brief Registers a texture created outside the catalog
+
+				Used for render targets, whose storage is created along with
+				their frame buffer. Returns the handle to use as catalog id.
+			*/
+			int registerTexture( unsigned int textureName, unsigned int size );
+
+			unsigned int getResourceCount( void ) const { return _resources.getCount(); }
+
+			/**
+				\brief Sampling used by textures without settings of their own
+
+				See SampledTexture. Affects textures loaded afterwards.
+			*/
+			void setDefaultSamplerState( const SamplerState &samplerState ) { _defaultSamplerState = samplerState; }
+			const SamplerState &getDefaultSamplerState( void ) const { return _defaultSamplerState; }
+
+			/**
+				\brief How mipmaps are built for textures not choosing themselves
+
+				Takes a SampledTexture::MipmapGeneration value. Defaults to GPU.
+			*/
+			void setDefaultMipmapGeneration( unsigned int mode ) { _defaultMipmapGeneration = mode; }
+			unsigned int getDefaultMipmapGeneration( void ) const { return _defaultMipmapGeneration; }
+
+			/**
+				\brief Checks whether the context can sample a CompressedImage::Format
+			*/
+			bool isCompressedFormatSupported( unsigned int format ) const;
+
+			/**
+				\brief Packs textures sharing size, format and sampling into texture arrays
+
+				Each texture becomes a layer of a GL_TEXTURE_2D_ARRAY, so 
+				draws that differ only by color map can keep the same 
+				texture bound and be instanced. Compressed and streamed 
+				textures keep their own 2D texture. Programs must sample 
+				array textures through a sampler2DArray, as the texture 
+				array programs in the library do. Affects textures loaded 
+				afterwards.
+			*/
+			void setTextureArraysEnabled( bool enabled ) { _textureArraysEnabled = enabled; }
+			bool isTextureArraysEnabled( void ) const { return _textureArraysEnabled; }
+
+			/**
+				\brief Checks if a texture is, or will be once loaded, a texture array layer
+			*/
+			bool usesTextureArray( Texture *texture );
+
+			/**
+				\brief Layer of a texture within its texture array, or -1
+			*/
+			int getTextureLayer( Texture *texture );
+
+			/**
+				\brief Identifies the texture array holding a texture, or -1
+
+				Textures report -1 until they are loaded. Two loaded 
+				textures with the same index can be sampled from the 
+				same bound array.
+			*/
+			int getTextureArrayIndex( Texture *texture );
+
+			/**
+				\brief Streams mipmap levels in and out as textures are needed
+
+				Mipmapped textures are loaded with their coarsest levels 
+				only. Finer levels are uploaded over the following frames, 
+				down to the level matching the size reported through 
+				requestSize, and dropped again when no longer needed or when 
+				textures go over the memory budget. The resident range of 
+				each texture starts at GL_TEXTURE_BASE_LEVEL.
+
+				Streamed textures keep their mipmap chain in system memory, 
+				so levels are always built on the CPU. Affects textures 
+				loaded afterwards.
+			*/
+			void setStreamingEnabled( bool enabled ) { _streamingEnabled = enabled; }
+			bool isStreamingEnabled( void ) const { return _streamingEnabled; }
+
+			/**
+				\brief Limit in bytes for all textures in the catalog, zero for no limit
+
+				Only levels finer than the initial ones are evicted to stay 
+				under the budget, so it can be exceeded if too many textures 
+				are loaded. When a requested level does not fit, textures 
+				used less recently than the requester give up levels first.
+			*/
+			void setMemoryBudget( unsigned int bytes ) { _memoryBudget = bytes; }
+			unsigned int getMemoryBudget( void ) const { return _memoryBudget; }
+
+			/**
+				\brief Maximum number of bytes streamed in during a single frame
+			*/
+			void setStreamingUploadLimit( unsigned int bytes ) { _streamingUploadLimit = bytes; }
+			unsigned int getStreamingUploadLimit( void ) const { return _streamingUploadLimit; }
+
+			/**
+				\brief Reports the size in pixels a texture covers on screen this frame
+
+				Only the largest size reported during a frame is kept. 
+				Textures bound without any size reported are streamed in 
+				up to their finest level.
+			*/
+			void requestSize( Texture *texture, float screenSize );
+
+			/**
+				\brief Uploads and evicts levels based on the sizes requested last frame
+
+				Called by the renderer when a frame begins.
+			*/
+			void updateStreaming( void );
+
+			/**
+				\brief Finest level currently resident for a texture
+			*/
+			unsigned int getResidentLevel( Texture *texture );
+
+			/**
+				\brief Bytes used by every texture in the catalog
+			*/
+			unsigned int getResidentSize( void );
+
 		private:
+			struct StreamingState {
+				MipChainPtr chain;
+				CompressedImage *compressed;
+				unsigned int levelCount;
+				unsigned int initialLevel;
+				unsigned int baseLevel;
+				unsigned int targetLevel;
+				unsigned int maxSize;
+				float requestedSize;
+				unsigned int lastRequestFrame;
+			};
+
+			struct TextureArray {
+				unsigned int name;
+				unsigned int width;
+				unsigned int height;
+				unsigned int bpp;
+				SamplerState samplerState;
+				unsigned int layerCount;
+				unsigned int usedLayerCount;
+				std::vector< unsigned int > freeLayers;
+			};
+
+			struct ArrayLayer {
+				unsigned int array;
+				unsigned int layer;
+			};
+
+			bool isTextureArrayCandidate( Texture *texture );
+			void loadArrayLayer( Texture *texture, Image *image, GpuResource *resource, const SamplerState &samplerState );
+			TextureArray &getTextureArray( Image *image, const SamplerState &samplerState );
+			void unloadArrayLayer( int handle );
+
+			void loadStreamed( Texture *texture, Image *image, GpuResource *resource );
+			unsigned int getLevelSize( const StreamingState &state, unsigned int level );
+			void uploadLevel( const StreamingState &state, GpuResource *resource, unsigned int level );
+			void streamIn( StreamingState &state, GpuResource *resource );
+			void evict( StreamingState &state, GpuResource *resource );
+			bool evictLeastRecentlyUsed( unsigned int usedBefore, unsigned int &residentSize );
+			unsigned int computeTargetLevel( StreamingState &state, GpuResource *resource );
+			void loadCompressed( CompressedImage *image, GpuResource *resource, const SamplerState &samplerState );
+			const SamplerState &getSamplerState( Texture *texture );
+			unsigned int getMipmapGeneration( Texture *texture );
+			bool areSamplerObjectsSupported( void ) const;
+			unsigned int getSamplerObject( const SamplerState &samplerState );
+			float getAnisotropy( const SamplerState &samplerState );
+			void applySamplerState( const SamplerState &samplerState, unsigned int target );
+
+			Renderer *_renderer;
+			GpuResourceTable _resources;
 			int _boundTextureCount;
+			SamplerState _defaultSamplerState;
+			unsigned int _defaultMipmapGeneration;
+			float _maxSupportedAnisotropy;
+
+			/**
+				\brief One sampler object for each distinct state, shared by textures
+			*/
+			std::map< SamplerState, unsigned int > _samplerObjects;
+
+			bool _textureArraysEnabled;
+			std::vector< TextureArray > _textureArrays;
+			std::map< int, ArrayLayer > _arrayLayers;
+
+			bool _streamingEnabled;
+			unsigned int _memoryBudget;
+			unsigned int _streamingUploadLimit;
+			std::map< int, StreamingState > _streamingStates;
+			std::vector< int > _streamingQueue;
 		};
 
 		typedef std::shared_ptr< TextureCatalog > TextureCatalogPtr;
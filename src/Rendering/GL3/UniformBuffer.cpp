@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UniformBuffer.hpp"
+#include "Utils.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace Crimild;
+
+GL3::UniformBuffer::UniformBuffer( unsigned int bindingPoint )
+	: _bindingPoint( bindingPoint ),
+	  _bufferId( 0 ),
+	  _reallocate( true ),
+	  _dirtyBegin( 0 ),
+	  _dirtyEnd( 0 ),
+	  _uploadCount( 0 )
+{
+
+}
+
+GL3::UniformBuffer::~UniformBuffer( void )
+{
+
+}
+
+void GL3::UniformBuffer::reserve( unsigned int size )
+{
+	if ( size > _data.size() ) {
+		_data.resize( size, 0 );
+		_reallocate = true;
+	}
+}
+
+void GL3::UniformBuffer::setData( unsigned int offset, const void *data, unsigned int size )
+{
+	if ( offset + size > _data.size() ) {
+		reserve( offset + size );
+	}
+
+	unsigned char *dst = &_data[ offset ];
+	if ( memcmp( dst, data, size ) == 0 ) {
+		return;
+	}
+
+	memcpy( dst, data, size );
+
+	if ( _dirtyBegin == _dirtyEnd ) {
+		_dirtyBegin = offset;
+		_dirtyEnd = offset + size;
+	}
+	else {
+		_dirtyBegin = std::min( _dirtyBegin, offset );
+		_dirtyEnd = std::max( _dirtyEnd, offset + size );
+	}
+}
+
+void GL3::UniformBuffer::commit( void )
+{
+	if ( _data.empty() || ( !_reallocate && _dirtyBegin == _dirtyEnd ) ) {
+		return;
+	}
+
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
+
+	if ( _bufferId == 0 ) {
+		glGenBuffers( 1, &_bufferId );
+	}
+
+	glBindBuffer( GL_UNIFORM_BUFFER, _bufferId );
+
+	if ( _reallocate ) {
+		glBufferData( GL_UNIFORM_BUFFER, _data.size(), &_data[ 0 ], GL_DYNAMIC_DRAW );
+		glBindBufferBase( GL_UNIFORM_BUFFER, _bindingPoint, _bufferId );
+		_reallocate = false;
+	}
+	else {
+		glBufferSubData( GL_UNIFORM_BUFFER, _dirtyBegin, _dirtyEnd - _dirtyBegin, &_data[ _dirtyBegin ] );
+	}
+
+	_dirtyBegin = _dirtyEnd = 0;
+	++_uploadCount;
+
+	CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+}
+
+void GL3::UniformBuffer::unload( void )
+{
+	if ( _bufferId > 0 ) {
+		glDeleteBuffers( 1, &_bufferId );
+		_bufferId = 0;
+	}
+
+	_reallocate = true;
+}
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_UNIFORM_BUFFER_
+#define CRIMILD_GL3_UNIFORM_BUFFER_
+
+#include <Crimild.hpp>
+
+#include <vector>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Backing storage for a std140 uniform block
+
+			Values are written into a CPU-side copy and only the modified
+			byte range is uploaded on commit(). The buffer is attached to
+			a fixed binding point shared by every program declaring the block.
+		*/
+		class UniformBuffer {
+		public:
+			class BindingPoint {
+			public:
+				enum {
+					CAMERA = 0,
+					LIGHTS = 1
+				};
+			};
+
+		public:
+			UniformBuffer( unsigned int bindingPoint );
+			virtual ~UniformBuffer( void );
+
+			unsigned int getBindingPoint( void ) const { return _bindingPoint; }
+
+			unsigned int getSize( void ) const { return _data.size(); }
+			void reserve( unsigned int size );
+
+			void setData( unsigned int offset, const void *data, unsigned int size );
+
+			void commit( void );
+			void unload( void );
+
+			unsigned int getUploadCount( void ) const { return _uploadCount; }
+			void resetCounters( void ) { _uploadCount = 0; }
+
+		private:
+			unsigned int _bindingPoint;
+			unsigned int _bufferId;
+			bool _reallocate;
+			std::vector< unsigned char > _data;
+			unsigned int _dirtyBegin;
+			unsigned int _dirtyEnd;
+			unsigned int _uploadCount;
+		};
+
+		typedef std::shared_ptr< UniformBuffer > UniformBufferPtr;
+
+	}
+
+}
+
+#endif
+
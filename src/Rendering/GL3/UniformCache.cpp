@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "UniformCache.hpp"
+
+#include <cstring>
+
+using namespace Crimild;
+
+GL3::UniformCache::UniformCache( void )
+	: _lastProgramId( 0 ),
+	  _lastProgramEntries( nullptr ),
+	  _hitCount( 0 ),
+	  _missCount( 0 )
+{
+
+}
+
+GL3::UniformCache::~UniformCache( void )
+{
+
+}
+
+bool GL3::UniformCache::update( unsigned int programId, int location, const void *data, unsigned int size )
+{
+	if ( location < 0 || size > sizeof( Entry::data ) ) {
+		++_missCount;
+		return true;
+	}
+
+	if ( _lastProgramEntries == nullptr || _lastProgramId != programId ) {
+		_lastProgramId = programId;
+		_lastProgramEntries = &_programs[ programId ];
+	}
+
+	Entry &entry = ( *_lastProgramEntries )[ location ];
+	if ( entry.size == size && memcmp( entry.data, data, size ) == 0 ) {
+		++_hitCount;
+		return false;
+	}
+
+	entry.size = size;
+	memcpy( entry.data, data, size );
+	++_missCount;
+	return true;
+}
+
+void GL3::UniformCache::invalidateProgram( unsigned int programId )
+{
+	_programs.erase( programId );
+	if ( _lastProgramId == programId ) {
+		_lastProgramEntries = nullptr;
+	}
+}
+
+void GL3::UniformCache::reset( void )
+{
+	_programs.clear();
+	_lastProgramEntries = nullptr;
+}
+
+void GL3::UniformCache::resetCounters( void )
+{
+	_hitCount = 0;
+	_missCount = 0;
+}
+
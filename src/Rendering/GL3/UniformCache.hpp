@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_UNIFORM_CACHE_
+#define CRIMILD_GL3_UNIFORM_CACHE_
+
+#include <Crimild.hpp>
+
+#include <unordered_map>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Last value uploaded to each uniform of each program
+
+			Uniform values are part of the program object's state, so a 
+			glUniform call can be skipped when the new value is bit-identical 
+			to the one uploaded before for the same (program, location) pair.
+
+			Entries are keyed by location, since drivers are free to hand out 
+			sparse location values and only the uniforms actually set need 
+			to be stored.
+		*/
+		class UniformCache {
+		public:
+			UniformCache( void );
+			virtual ~UniformCache( void );
+
+			/**
+				\brief Records a value for a uniform
+
+				\returns true if the value differs from the cached one and 
+				must be uploaded, false otherwise
+			*/
+			bool update( unsigned int programId, int location, const void *data, unsigned int size );
+
+			void invalidateProgram( unsigned int programId );
+			void reset( void );
+
+			unsigned int getHitCount( void ) const { return _hitCount; }
+			unsigned int getMissCount( void ) const { return _missCount; }
+			void resetCounters( void );
+
+		private:
+			struct Entry {
+				unsigned int size;
+				unsigned char data[ 64 ];
+
+				Entry( void ) : size( 0 ) { }
+			};
+
+			typedef std::unordered_map< int, Entry > EntryMap;
+
+			std::unordered_map< unsigned int, EntryMap > _programs;
+
+			unsigned int _lastProgramId;
+			EntryMap *_lastProgramEntries;
+
+			unsigned int _hitCount;
+			unsigned int _missCount;
+		};
+
+		typedef std::shared_ptr< UniformCache > UniformCachePtr;
+
+	}
+
+}
+
+#endif
+
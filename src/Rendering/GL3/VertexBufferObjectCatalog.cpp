@@ -26,14 +26,33 @@
  */
 
 #include "VertexBufferObjectCatalog.hpp"
+#include "Renderer.hpp"
+#include "ShaderProgramCatalog.hpp"
+#include "DynamicVertexBufferObject.hpp"
+#include "PackedVertexLayout.hpp"
 #include "Utils.hpp"
 
 #include <GL/glew.h>
 #include <GL/glfw.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 using namespace Crimild;
 
-GL3::VertexBufferObjectCatalog::VertexBufferObjectCatalog( void )
+namespace {
+
+	// buffers up to this size are packed together in shared pools
+	const unsigned int MAX_POOLED_BUFFER_SIZE = 64 * 1024;
+	const unsigned int VERTEX_POOL_CAPACITY = 4 * 1024 * 1024;
+
+}
+
+GL3::VertexBufferObjectCatalog::VertexBufferObjectCatalog( Renderer *renderer )
+	: _renderer( renderer ),
+	  _vertexPacking( PackedVertexLayout::Packing::PACKED_NORMALS | PackedVertexLayout::Packing::NORMALIZED_TEXTURE_COORDS | PackedVertexLayout::Packing::NORMALIZED_COLORS ),
+	  _positionStreamEnabled( false )
 {
 
 }
@@ -45,114 +64,93 @@ GL3::VertexBufferObjectCatalog::~VertexBufferObjectCatalog( void )
 
 int GL3::VertexBufferObjectCatalog::getNextResourceId( void )
 {
-	int compositeId;
+	// GL objects are created on load, once it is known 
+	// whether the buffer gets its own storage or not
+	return _resources.create( GpuResource() );
+}
 
-	GLuint vaoId;
-	glGenVertexArrays( 1, &vaoId );
+void GL3::VertexBufferObjectCatalog::bind( ShaderProgram *program, VertexBufferObject *vbo )
+{
+	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-	glBindVertexArray( vaoId );
+	// loads the buffer the first time it is bound
+	Catalog< VertexBufferObject >::bind( program, vbo );
 
-	GLuint vboId;    
-    glGenBuffers( 1, &vboId );
+	updateDirtyRanges( vbo );
 
-    return composeId( vaoId, vboId );
-}
+	GpuResource *resource = getResource( vbo );
+	if ( resource != nullptr ) {
+		ShaderProgramCatalog *programCatalog = static_cast< ShaderProgramCatalog * >( getRenderer()->getShaderProgramCatalog() );
+		unsigned int signature = program != nullptr ? programCatalog->getAttributeSignature( program ) : 0;
 
-int GL3::VertexBufferObjectCatalog::composeId( unsigned int vaoId, unsigned int vboId )
-{
-	return vaoId * 1000 + vboId;
+		PositionStream *stream = selectPositionStream( program, vbo );
+		if ( stream != nullptr ) {
+			getRenderer()->getStateCache()->bindVertexArray( stream->vaoId );
+		}
+		else if ( signature == 0 ) {
+			getRenderer()->getStateCache()->bindVertexArray( resource->auxName );
+		}
+		else {
+			getRenderer()->getStateCache()->bindVertexArray( getLayoutVertexArray( vbo, resource, signature ) );
+		}
+
+		if ( dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+			streamVertexBuffer( vbo, resource, signature );
+		}
+
+		resource->lastUseFrame = getRenderer()->getFrameNumber();
+	}
+
+    CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
 
-bool GL3::VertexBufferObjectCatalog::extractId( int compositeId, unsigned int &vaoId, unsigned int &vboId )
+unsigned int GL3::VertexBufferObjectCatalog::getLayoutVertexArray( VertexBufferObject *vbo, GpuResource *resource, unsigned int signature )
 {
-	vaoId = compositeId / 1000;
-	vboId = compositeId % 1000;
-	return true;
+	auto key = std::make_pair( vbo->getCatalogId(), signature );
+	auto it = _layoutVertexArrays.find( key );
+	if ( it != _layoutVertexArrays.end() ) {
+		return it->second;
+	}
+
+	// configured once, then reused every time this buffer 
+	// is drawn with a program sharing the same signature
+	GLuint vaoId;
+	glGenVertexArrays( 1, &vaoId );
+	if ( dynamic_cast< DynamicVertexBufferObject * >( vbo ) == nullptr ) {
+		getRenderer()->getStateCache()->bindVertexArray( vaoId );
+		glBindBuffer( GL_ARRAY_BUFFER, resource->name );
+		PackedVertexLayout( vbo->getVertexFormat(), resource->format ).configureAttributes( signature, 0 );
+	}
+	// dynamic buffers have no store of their own until streamed, 
+	// so streamVertexBuffer() sets their pointers on every bind
+
+	_layoutVertexArrays[ key ] = vaoId;
+	return vaoId;
 }
 
-void GL3::VertexBufferObjectCatalog::bind( ShaderProgram *program, VertexBufferObject *vbo )
+void GL3::VertexBufferObjectCatalog::streamVertexBuffer( VertexBufferObject *vbo, GpuResource *resource, unsigned int signature )
 {
-	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
-
-	GLuint vaoId, vboId;
-
-	if ( vbo->getCatalog() == nullptr ) {
-		Catalog< VertexBufferObject >::bind( program, vbo );		
-
-		extractId( vbo->getCatalogId(), vaoId, vboId );
-
-		glBindVertexArray( vaoId );
-
-	    glBindBuffer( GL_ARRAY_BUFFER, vboId );
-	    float *baseOffset = 0;
-
-	    const VertexFormat &format = vbo->getVertexFormat();
-
-	    ShaderLocation *positionLocation = program->getStandardLocation( ShaderProgram::StandardLocation::POSITION_ATTRIBUTE );
-	    if ( positionLocation && positionLocation->isValid() ) {
-	        if ( format.hasPositions() ) {
-	            glEnableVertexAttribArray( positionLocation->getLocation() );
-	            glVertexAttribPointer( positionLocation->getLocation(),
-	                                   format.getPositionComponents(),
-	                                   GL_FLOAT,
-	                                   GL_FALSE,
-	                                   format.getVertexSizeInBytes(),
-	                                   ( const GLvoid * )( baseOffset + format.getPositionsOffset() ) );
-	        }
-	    }
-
-	    ShaderLocation *normalLocation = program->getStandardLocation( ShaderProgram::StandardLocation::NORMAL_ATTRIBUTE );
-	    if ( normalLocation && normalLocation->isValid() ) {
-	        if ( format.hasPositions() ) {
-	            glEnableVertexAttribArray( normalLocation->getLocation() );
-	            glVertexAttribPointer( normalLocation->getLocation(),
-	                                   format.getNormalComponents(),
-	                                   GL_FLOAT,
-	                                   GL_FALSE,
-	                                   format.getVertexSizeInBytes(),
-	                                   ( const GLvoid * )( baseOffset + format.getNormalsOffset() ) );
-	        }
-	    }
-
-	    ShaderLocation *colorLocation = program->getStandardLocation( ShaderProgram::StandardLocation::COLOR_ATTRIBUTE );
-	    if ( colorLocation && colorLocation->isValid() ) {
-	        if ( format.hasColors() ) {
-	            glEnableVertexAttribArray( colorLocation->getLocation() );
-	            glVertexAttribPointer( colorLocation->getLocation(),
-	                                   format.getColorComponents(),
-	                                   GL_FLOAT,
-	                                   GL_FALSE,
-	                                   format.getVertexSizeInBytes(),
-	                                   ( const GLvoid * )( baseOffset + format.getColorsOffset() ) );
-	        }
-	    }
-
-	    ShaderLocation *uvLocation = program->getStandardLocation( ShaderProgram::StandardLocation::TEXTURE_COORD_ATTRIBUTE );
-	    if ( uvLocation && uvLocation->isValid() ) {
-	        if ( format.hasTextureCoords() ) {
-	            glEnableVertexAttribArray( uvLocation->getLocation() );
-	            glVertexAttribPointer( uvLocation->getLocation(),
-	                                   format.getTextureCoordComponents(),
-	                                   GL_FLOAT,
-	                                   GL_FALSE,
-	                                   format.getVertexSizeInBytes(),
-	                                   ( const GLvoid * )( baseOffset + format.getTextureCoordsOffset() ) );
-	        }
-	    }
-	}
-
-	extractId( vbo->getCatalogId(), vaoId, vboId );
-	glBindVertexArray( vaoId );
+	// contents are uploaded once per frame, no matter how many 
+	// times the buffer is drawn. If the stream grew since the last 
+	// write, the old offset points into a discarded store
+	StreamBuffer *stream = getRenderer()->getVertexStream();
+	if ( resource->lastUseFrame != getRenderer()->getFrameNumber() || resource->name != stream->getBufferId() || resource->storeGeneration != stream->getGeneration() ) {
+		resource->offset = stream->write( vbo->getData(), resource->size );
+		resource->name = stream->getBufferId();
+		resource->storeGeneration = stream->getGeneration();
+	}
 
-    CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
+	// the offset moves every frame, so pointers are always respecified
+	glBindBuffer( GL_ARRAY_BUFFER, resource->name );
+	configureAttributes( vbo->getVertexFormat(), signature, resource->offset );
 }
 
 void GL3::VertexBufferObjectCatalog::unbind( ShaderProgram *program, VertexBufferObject *vbo )
 {
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-    glBindVertexArray( 0 );
-    
+	// the VAO is left bound, so the state cache can skip 
+	// the next bind if the same buffer is drawn again
 	Catalog< VertexBufferObject >::unbind( program, vbo );
 
     CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
@@ -164,29 +162,394 @@ void GL3::VertexBufferObjectCatalog::load( VertexBufferObject *vbo )
 
 	Catalog< VertexBufferObject >::load( vbo );
 
-	GLuint vaoId, vboId;
-	extractId( vbo->getCatalogId(), vaoId, vboId );
+	GpuResource *resource = getResource( vbo );
+	const VertexFormat &format = vbo->getVertexFormat();
 
-	glBindVertexArray( vaoId );	
-
-    glBindBuffer( GL_ARRAY_BUFFER, vboId );
-    glBufferData( GL_ARRAY_BUFFER,
-         vbo->getVertexFormat().getVertexSizeInBytes() * vbo->getVertexCount(),
-         vbo->getData(),
-         GL_STATIC_DRAW );
+	if ( dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+		// data lives in the renderer's stream buffer and is uploaded on bind
+		resource->size = format.getVertexSizeInBytes() * vbo->getVertexCount();
+		resource->format = PackedVertexLayout::Packing::NONE;
+		glGenVertexArrays( 1, &resource->auxName );
+		resource->lastUseFrame = 0;
+	}
+	else {
+		// the packing actually used is kept as the resource format
+		PackedVertexLayout layout( format, PackedVertexLayout::selectPacking( format, vbo->getData(), vbo->getVertexCount(), _vertexPacking ) );
+		resource->size = layout.getStride() * vbo->getVertexCount();
+		resource->format = layout.getPacking();
+		resource->lastUseFrame = getRenderer()->getFrameNumber();
+
+		const void *data = vbo->getData();
+		if ( layout.getPacking() != PackedVertexLayout::Packing::NONE && resource->size > 0 ) {
+			_staging.resize( resource->size );
+			layout.pack( vbo->getData(), vbo->getVertexCount(), &_staging[ 0 ] );
+			data = &_staging[ 0 ];
+		}
+
+		if ( resource->size > MAX_POOLED_BUFFER_SIZE || !loadPooled( vbo, resource, layout, data ) ) {
+			glGenVertexArrays( 1, &resource->auxName );
+			getRenderer()->getStateCache()->bindVertexArray( resource->auxName );
+
+			glGenBuffers( 1, &resource->name );
+		    glBindBuffer( GL_ARRAY_BUFFER, resource->name );
+		    glBufferData( GL_ARRAY_BUFFER,
+		         resource->size,
+		         data,
+		         GL_STATIC_DRAW );
+
+		    // attribute slots are fixed for every program, so the vertex
+		    // array can be configured once without knowing who will use it
+		    layout.configureAttributes( 0, 0 );
+		}
+
+		if ( _positionStreamEnabled ) {
+			loadPositionStream( vbo, layout.getPacking() );
+		}
+	}
 
     CRIMILD_CHECK_GL_ERRORS_AFTER_CURRENT_FUNCTION;
 }
 
+bool GL3::VertexBufferObjectCatalog::loadPooled( VertexBufferObject *vbo, GpuResource *resource, const PackedVertexLayout &layout, const void *data )
+{
+	VertexPool *pool = allocatePooled( layout, resource->size, vbo->getCatalogId(), resource->offset, data );
+	if ( pool == nullptr ) {
+		return false;
+	}
+
+	resource->name = pool->pool->getBufferId();
+	resource->auxName = pool->vaoId;
+	resource->lastUseFrame = getRenderer()->getFrameNumber();
+
+	return true;
+}
+
+GL3::VertexBufferObjectCatalog::VertexPool *GL3::VertexBufferObjectCatalog::allocatePooled( const PackedVertexLayout &layout, unsigned int size, int owner, unsigned int &offset, const void *data )
+{
+	const VertexFormat &format = layout.getVertexFormat();
+	unsigned int stride = layout.getStride();
+
+	VertexPool *target = nullptr;
+	for ( auto &pool : _vertexPools ) {
+		if ( pool.format == format && pool.packing == layout.getPacking() && pool.pool->allocate( size, stride, owner, offset ) ) {
+			target = &pool;
+			break;
+		}
+	}
+
+	if ( target == nullptr ) {
+		_vertexPools.push_back( VertexPool( format, layout.getPacking(), BufferPoolPtr( new BufferPool( VERTEX_POOL_CAPACITY - VERTEX_POOL_CAPACITY % stride ) ) ) );
+		target = &_vertexPools.back();
+		if ( !target->pool->allocate( size, stride, owner, offset ) ) {
+			_vertexPools.pop_back();
+			return nullptr;
+		}
+	}
+
+	target->pool->upload( offset, data, size );
+
+	if ( target->vaoId == 0 ) {
+		// every buffer in the pool shares this vertex array and 
+		// is selected with a base vertex when drawing
+		glGenVertexArrays( 1, &target->vaoId );
+		getRenderer()->getStateCache()->bindVertexArray( target->vaoId );
+		glBindBuffer( GL_ARRAY_BUFFER, target->pool->getBufferId() );
+		layout.configureAttributes( 0, 0 );
+	}
+
+	return target;
+}
+
+void GL3::VertexBufferObjectCatalog::releasePooled( VertexPool *pool, unsigned int offset )
+{
+	pool->pool->release( offset );
+	if ( !pool->pool->shouldDefragment() ) {
+		return;
+	}
+
+	pool->pool->defragment( [&]( int owner, unsigned int newOffset ) {
+		if ( owner < 0 ) {
+			auto stream = _positionStreams.find( -owner );
+			if ( stream != _positionStreams.end() ) {
+				stream->second.offset = newOffset;
+			}
+		}
+		else {
+			GpuResource *moved = _resources.get( owner );
+			if ( moved != nullptr ) {
+				moved->offset = newOffset;
+			}
+		}
+	});
+}
+
+void GL3::VertexBufferObjectCatalog::invalidate( VertexBufferObject *vbo, unsigned int firstVertex, unsigned int vertexCount )
+{
+	if ( getResource( vbo ) == nullptr || dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+		return;
+	}
+
+	unsigned int end = std::min( firstVertex + vertexCount, vbo->getVertexCount() );
+	_dirtyRanges[ vbo->getCatalogId() ].insert( firstVertex, end );
+	_boundingRadii.erase( vbo->getCatalogId() );
+}
+
+float GL3::VertexBufferObjectCatalog::getBoundingRadius( VertexBufferObject *vbo )
+{
+	const VertexFormat &format = vbo->getVertexFormat();
+	if ( !format.hasPositions() ) {
+		return 0.0f;
+	}
+
+	bool cacheable = getResource( vbo ) != nullptr && dynamic_cast< DynamicVertexBufferObject * >( vbo ) == nullptr;
+	if ( cacheable ) {
+		auto it = _boundingRadii.find( vbo->getCatalogId() );
+		if ( it != _boundingRadii.end() ) {
+			return it->second;
+		}
+	}
+
+	unsigned int vertexSize = format.getVertexSize();
+	unsigned int components = format.getPositionComponents();
+	const float *position = vbo->getData() + format.getPositionsOffset();
+	float squaredRadius = 0.0f;
+	for ( unsigned int i = 0; i < vbo->getVertexCount(); i++ ) {
+		float squaredDistance = 0.0f;
+		for ( unsigned int c = 0; c < components; c++ ) {
+			squaredDistance += position[ c ] * position[ c ];
+		}
+		squaredRadius = std::max( squaredRadius, squaredDistance );
+		position += vertexSize;
+	}
+
+	float radius = std::sqrt( squaredRadius );
+	if ( cacheable ) {
+		_boundingRadii[ vbo->getCatalogId() ] = radius;
+	}
+
+	return radius;
+}
+
+void GL3::VertexBufferObjectCatalog::updateDirtyRanges( VertexBufferObject *vbo )
+{
+	auto it = _dirtyRanges.find( vbo->getCatalogId() );
+	if ( it == _dirtyRanges.end() ) {
+		return;
+	}
+
+	DirtyRangeSet ranges = it->second;
+	_dirtyRanges.erase( it );
+
+	GpuResource *resource = getResource( vbo );
+	if ( resource == nullptr ) {
+		return;
+	}
+
+	const VertexFormat &format = vbo->getVertexFormat();
+	unsigned int vertexSize = format.getVertexSize();
+
+	bool fits = true;
+	ranges.foreachRange( [&]( unsigned int begin, unsigned int end ) {
+		unsigned int packing = PackedVertexLayout::selectPacking( format, vbo->getData() + begin * vertexSize, end - begin, resource->format );
+		if ( packing != resource->format ) {
+			fits = false;
+		}
+	});
+
+	if ( !fits ) {
+		// some attribute left the range of its packed type
+		unload( vbo );
+		load( vbo );
+		return;
+	}
+
+	PackedVertexLayout layout( format, resource->format );
+	unsigned int stride = layout.getStride();
+
+	auto stream = _positionStreams.find( vbo->getCatalogId() );
+	PackedVertexLayout positionLayout( VertexFormat( format.getPositionComponents(), 0, 0, 0 ), resource->format & PackedVertexLayout::Packing::HALF_POSITIONS );
+	std::vector< float > positions;
+
+	// the copy target leaves the element array binding of the current vertex array untouched
+	ranges.foreachRange( [&]( unsigned int begin, unsigned int end ) {
+		unsigned int count = end - begin;
+		const float *src = vbo->getData() + begin * vertexSize;
+
+		_staging.resize( count * stride );
+		layout.pack( src, count, &_staging[ 0 ] );
+		glBindBuffer( GL_COPY_WRITE_BUFFER, resource->name );
+		glBufferSubData( GL_COPY_WRITE_BUFFER, resource->offset + begin * stride, count * stride, &_staging[ 0 ] );
+
+		if ( stream != _positionStreams.end() ) {
+			unsigned int components = format.getPositionComponents();
+			positions.resize( count * components );
+			for ( unsigned int i = 0; i < count; i++ ) {
+				memcpy( &positions[ i * components ], src + i * vertexSize + format.getPositionsOffset(), components * sizeof( float ) );
+			}
+
+			_staging.resize( count * positionLayout.getStride() );
+			positionLayout.pack( &positions[ 0 ], count, &_staging[ 0 ] );
+			glBindBuffer( GL_COPY_WRITE_BUFFER, stream->second.vboId );
+			glBufferSubData( GL_COPY_WRITE_BUFFER, stream->second.offset + begin * positionLayout.getStride(), count * positionLayout.getStride(), &_staging[ 0 ] );
+		}
+	});
+
+	glBindBuffer( GL_COPY_WRITE_BUFFER, 0 );
+}
+
+void GL3::VertexBufferObjectCatalog::loadPositionStream( VertexBufferObject *vbo, unsigned int packing )
+{
+	const VertexFormat &format = vbo->getVertexFormat();
+	if ( !format.hasPositions() || ( !format.hasNormals() && !format.hasColors() && !format.hasTextureCoords() ) ) {
+		// the interleaved buffer is already position-only
+		return;
+	}
+
+	unsigned int vertexCount = vbo->getVertexCount();
+	unsigned int vertexSize = format.getVertexSize();
+	unsigned int components = format.getPositionComponents();
+
+	std::vector< float > positions( vertexCount * components );
+	const float *src = vbo->getData();
+	for ( unsigned int i = 0; i < vertexCount; i++ ) {
+		memcpy( &positions[ i * components ], src + i * vertexSize + format.getPositionsOffset(), components * sizeof( float ) );
+	}
+
+	// positions keep the same precision as in the interleaved buffer
+	PackedVertexLayout layout( VertexFormat( components, 0, 0, 0 ), packing & PackedVertexLayout::Packing::HALF_POSITIONS );
+	_staging.resize( layout.getStride() * vertexCount );
+	if ( vertexCount > 0 ) {
+		layout.pack( &positions[ 0 ], vertexCount, &_staging[ 0 ] );
+	}
+
+	// the pool handle is negated so relocations can tell streams apart from buffers
+	PositionStream stream;
+	stream.offset = 0;
+	stream.stride = layout.getStride();
+	unsigned int size = _staging.size();
+	const void *data = vertexCount > 0 ? &_staging[ 0 ] : nullptr;
+	VertexPool *pool = size > 0 && size <= MAX_POOLED_BUFFER_SIZE ? allocatePooled( layout, size, -vbo->getCatalogId(), stream.offset, data ) : nullptr;
+	if ( pool != nullptr ) {
+		stream.vboId = pool->pool->getBufferId();
+		stream.vaoId = pool->vaoId;
+	}
+	else {
+		glGenVertexArrays( 1, &stream.vaoId );
+		getRenderer()->getStateCache()->bindVertexArray( stream.vaoId );
+
+		glGenBuffers( 1, &stream.vboId );
+		glBindBuffer( GL_ARRAY_BUFFER, stream.vboId );
+		glBufferData( GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW );
+		layout.configureAttributes( 0, 0 );
+	}
+
+	_positionStreams[ vbo->getCatalogId() ] = stream;
+}
+
+void GL3::VertexBufferObjectCatalog::unloadPositionStream( int handle )
+{
+	auto it = _positionStreams.find( handle );
+	if ( it == _positionStreams.end() ) {
+		return;
+	}
+
+	PositionStream stream = it->second;
+	_positionStreams.erase( it );
+
+	VertexPool *pool = getPool( stream.vaoId );
+	if ( pool != nullptr ) {
+		releasePooled( pool, stream.offset );
+	}
+	else {
+		glDeleteBuffers( 1, &stream.vboId );
+		glDeleteVertexArrays( 1, &stream.vaoId );
+		getRenderer()->getStateCache()->invalidateVertexArray( stream.vaoId );
+	}
+}
+
+GL3::VertexBufferObjectCatalog::PositionStream *GL3::VertexBufferObjectCatalog::selectPositionStream( ShaderProgram *program, VertexBufferObject *vbo )
+{
+	if ( program == nullptr ) {
+		return nullptr;
+	}
+
+	auto stream = _positionStreams.find( vbo->getCatalogId() );
+	if ( stream == _positionStreams.end() ) {
+		return nullptr;
+	}
+
+	ShaderProgramCatalog *programCatalog = static_cast< ShaderProgramCatalog * >( getRenderer()->getShaderProgramCatalog() );
+	if ( programCatalog->getAttributeSignature( program ) != 0 || !programCatalog->isPositionOnly( program ) ) {
+		return nullptr;
+	}
+
+	return &stream->second;
+}
+
+GL3::VertexBufferObjectCatalog::VertexPool *GL3::VertexBufferObjectCatalog::getPool( unsigned int vaoId )
+{
+	for ( auto &pool : _vertexPools ) {
+		if ( pool.vaoId != 0 && pool.vaoId == vaoId ) {
+			return &pool;
+		}
+	}
+
+	return nullptr;
+}
+
+int GL3::VertexBufferObjectCatalog::getBaseVertex( ShaderProgram *program, VertexBufferObject *vbo )
+{
+	GpuResource *resource = getResource( vbo );
+	if ( resource == nullptr || dynamic_cast< DynamicVertexBufferObject * >( vbo ) != nullptr ) {
+		// dynamic buffers point attributes at their stream offset instead
+		return 0;
+	}
+
+	// chosen the same way as when the buffer was bound
+	PositionStream *stream = selectPositionStream( program, vbo );
+	if ( stream != nullptr ) {
+		return stream->offset / stream->stride;
+	}
+
+	return resource->offset / PackedVertexLayout( vbo->getVertexFormat(), resource->format ).getStride();
+}
+
+void GL3::VertexBufferObjectCatalog::configureAttributes( const VertexFormat &format, unsigned int signature, unsigned int byteOffset )
+{
+	PackedVertexLayout( format, PackedVertexLayout::Packing::NONE ).configureAttributes( signature, byteOffset );
+}
+
 void GL3::VertexBufferObjectCatalog::unload( VertexBufferObject *vbo )
 {
 	CRIMILD_CHECK_GL_ERRORS_BEFORE_CURRENT_FUNCTION;
 
-	GLuint vaoId, vboId;
-	extractId( vbo->getCatalogId(), vaoId, vboId );
-
-    glDeleteBuffers( 1, &vboId );
-	glDeleteVertexArrays( 1, &vaoId );
+	int handle = vbo->getCatalogId();
+	GpuResource *resource = _resources.get( handle );
+	if ( resource != nullptr ) {
+		VertexPool *pool = getPool( resource->auxName );
+		if ( pool != nullptr ) {
+			releasePooled( pool, resource->offset );
+		}
+		else {
+			if ( dynamic_cast< DynamicVertexBufferObject * >( vbo ) == nullptr ) {
+				glDeleteBuffers( 1, &resource->name );
+			}
+			glDeleteVertexArrays( 1, &resource->auxName );
+			getRenderer()->getStateCache()->invalidateVertexArray( resource->auxName );
+		}
+		_resources.release( handle );
+		_dirtyRanges.erase( handle );
+		_boundingRadii.erase( handle );
+		unloadPositionStream( handle );
+
+		auto it = _layoutVertexArrays.lower_bound( std::make_pair( handle, 0u ) );
+		while ( it != _layoutVertexArrays.end() && it->first.first == handle ) {
+			GLuint vaoId = it->second;
+			glDeleteVertexArrays( 1, &vaoId );
+			getRenderer()->getStateCache()->invalidateVertexArray( vaoId );
+			it = _layoutVertexArrays.erase( it );
+		}
+	}
 
 	Catalog< VertexBufferObject >::unload( vbo );
 
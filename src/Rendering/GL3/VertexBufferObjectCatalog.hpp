@@ -28,17 +28,29 @@
 #ifndef CRIMILD_GL3_VERTEX_BUFFER_OBJECT_CATALOG_
 #define CRIMILD_GL3_VERTEX_BUFFER_OBJECT_CATALOG_
 
+#include "HandleTable.hpp"
+#include "BufferPool.hpp"
+#include "DirtyRangeSet.hpp"
+#include "PackedVertexLayout.hpp"
+
 #include <Crimild.hpp>
 
+#include <map>
+#include <vector>
+
 namespace Crimild {
 
 	namespace GL3 {
 
+		class Renderer;
+
 		class VertexBufferObjectCatalog : public Catalog< VertexBufferObject > {
 		public:
-			VertexBufferObjectCatalog( void );
+			VertexBufferObjectCatalog( Renderer *renderer );
 			virtual ~VertexBufferObjectCatalog( void );
 
+			Renderer *getRenderer( void ) { return _renderer; }
+
 			virtual int getNextResourceId( void ) override;
 
 			virtual void bind( ShaderProgram *program, VertexBufferObject *vbo ) override;
@@ -47,9 +59,130 @@ namespace Crimild {
 			virtual void load( VertexBufferObject *vbo ) override;
 			virtual void unload( VertexBufferObject *vbo ) override;
 
+			/**
+				\brief Sets up attribute pointers in the bound vertex array
+
+				Attributes are mapped to the slots in ShaderProgramCatalog::AttributeSlot,
+				or to the locations described by a program's attribute signature
+			*/
+			static void configureAttributes( const VertexFormat &format, unsigned int signature = 0, unsigned int byteOffset = 0 );
+
+			/**
+				\brief Returns the GL names for a loaded buffer, or null
+			*/
+			GpuResource *getResource( VertexBufferObject *vbo ) { return _resources.get( vbo->getCatalogId() ); }
+
+			unsigned int getResourceCount( void ) const { return _resources.getCount(); }
+
+			/**
+				\brief Vertex offset to add to indices when drawing the buffer
+
+				Small buffers are sub-allocated from shared pools and drawn 
+				through the pool's vertex array, so their first vertex is 
+				not at the start of the GL buffer. The program must be the 
+				one the buffer was bound with, since it decides whether the 
+				position stream is used.
+			*/
+			int getBaseVertex( ShaderProgram *program, VertexBufferObject *vbo );
+
+			/**
+				\brief Selects which attributes may be stored in compact types
+
+				Takes a combination of PackedVertexLayout::Packing values. 
+				Each buffer only uses the options its data fits in, and 
+				changes affect buffers loaded afterwards. Half float 
+				positions are disabled by default, since they lose 
+				precision on large models.
+			*/
+			void setVertexPacking( unsigned int packing ) { _vertexPacking = packing; }
+			unsigned int getVertexPacking( void ) const { return _vertexPacking; }
+
+			/**
+				\brief Uploads a separate position-only stream for each static buffer
+
+				Programs reading nothing but positions, like depth or 
+				picking passes, are then drawn through a vertex array 
+				fetching only that stream. Small streams share pools just 
+				like interleaved buffers. Affects buffers loaded afterwards.
+			*/
+			void setPositionStreamEnabled( bool enabled ) { _positionStreamEnabled = enabled; }
+			bool isPositionStreamEnabled( void ) const { return _positionStreamEnabled; }
+
+			/**
+				\brief Marks a range of vertices as modified
+
+				Modified ranges are merged and uploaded the next time the 
+				buffer is bound, instead of reloading the whole buffer. If 
+				the new data no longer fits the packing selected on load, 
+				the buffer is reloaded. Does nothing for buffers not loaded 
+				yet, or for dynamic buffers, which are uploaded every frame.
+			*/
+			void invalidate( VertexBufferObject *vbo, unsigned int firstVertex, unsigned int vertexCount );
+
+			/**
+				\brief Distance from the origin to the farthest vertex
+
+				Cached for loaded static buffers until they are unloaded 
+				or invalidated. Buffers not loaded yet and dynamic buffers 
+				are measured on every call.
+			*/
+			float getBoundingRadius( VertexBufferObject *vbo );
+
 		private:
-			int composeId( unsigned int vaoId, unsigned int vboId );
-			bool extractId( int compositeId, unsigned int &vaoId, unsigned int &vboId );
+			struct VertexPool {
+				VertexPool( const VertexFormat &f, unsigned int k, BufferPoolPtr p ) : format( f ), packing( k ), pool( p ), vaoId( 0 ) { }
+
+				// owners are buffer handles, negated for position streams
+
+				VertexFormat format;
+				unsigned int packing;
+				BufferPoolPtr pool;
+				unsigned int vaoId;
+			};
+
+			/**
+				\brief Position-only copy of a static buffer
+
+				Lives either in a pool, sharing its GL names, or in a 
+				buffer and vertex array of its own.
+			*/
+			struct PositionStream {
+				unsigned int vboId;
+				unsigned int vaoId;
+				unsigned int offset;
+				unsigned int stride;
+			};
+
+			bool loadPooled( VertexBufferObject *vbo, GpuResource *resource, const PackedVertexLayout &layout, const void *data );
+			VertexPool *allocatePooled( const PackedVertexLayout &layout, unsigned int size, int owner, unsigned int &offset, const void *data );
+			void releasePooled( VertexPool *pool, unsigned int offset );
+			void loadPositionStream( VertexBufferObject *vbo, unsigned int packing );
+			void unloadPositionStream( int handle );
+			PositionStream *selectPositionStream( ShaderProgram *program, VertexBufferObject *vbo );
+			void updateDirtyRanges( VertexBufferObject *vbo );
+			VertexPool *getPool( unsigned int vaoId );
+			unsigned int getLayoutVertexArray( VertexBufferObject *vbo, GpuResource *resource, unsigned int signature );
+			void streamVertexBuffer( VertexBufferObject *vbo, GpuResource *resource, unsigned int signature );
+
+			Renderer *_renderer;
+			GpuResourceTable _resources;
+
+			/**
+				\brief Extra vertex arrays for programs not following the fixed slots
+
+				Keyed by buffer handle and attribute signature
+			*/
+			std::map< std::pair< int, unsigned int >, unsigned int > _layoutVertexArrays;
+
+			std::vector< VertexPool > _vertexPools;
+			unsigned int _vertexPacking;
+			std::vector< unsigned char > _staging;
+
+			bool _positionStreamEnabled;
+			std::map< int, PositionStream > _positionStreams;
+
+			std::map< int, DirtyRangeSet > _dirtyRanges;
+			std::map< int, float > _boundingRadii;
 		};
 
 		typedef std::shared_ptr< VertexBufferObjectCatalog > VertexBufferObjectCatalogPtr;
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "VertexLayout.hpp"
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+using namespace Crimild;
+
+void GL3::VertexLayoutUtils::setAttributePointer( unsigned int signature, unsigned int slot, unsigned int components, unsigned int format, unsigned int stride, unsigned int offset )
+{
+	int location = ShaderProgramCatalog::getAttributeLocation( signature, slot );
+	if ( location < 0 ) {
+		return;
+	}
+
+	GLenum type = GL_FLOAT;
+	GLboolean normalized = GL_FALSE;
+	switch ( format ) {
+		case VertexAttributeFormat::HALF_FLOAT:
+			type = GL_HALF_FLOAT;
+			break;
+
+		case VertexAttributeFormat::PACKED_INT_2_10_10_10:
+			// the fourth component is always read, even if unused
+			type = GL_INT_2_10_10_10_REV;
+			normalized = GL_TRUE;
+			components = 4;
+			break;
+
+		case VertexAttributeFormat::NORMALIZED_UNSIGNED_SHORT:
+			type = GL_UNSIGNED_SHORT;
+			normalized = GL_TRUE;
+			break;
+
+		case VertexAttributeFormat::NORMALIZED_UNSIGNED_BYTE:
+			type = GL_UNSIGNED_BYTE;
+			normalized = GL_TRUE;
+			break;
+
+		case VertexAttributeFormat::FLOAT:
+		default:
+			break;
+	}
+
+	unsigned char *base = 0;
+	glEnableVertexAttribArray( location );
+	glVertexAttribPointer( location, components, type, normalized, stride, ( const GLvoid * )( base + offset ) );
+}
+
+bool GL3::VertexLayoutUtils::validate( ShaderProgram *program, unsigned int slotMask )
+{
+	bool valid = true;
+
+	auto check = [&]( unsigned int standardLocation, unsigned int slot ) {
+		ShaderLocation *location = program->getStandardLocation( standardLocation );
+		if ( location != nullptr && location->isValid() && ( slotMask & ( 1 << slot ) ) == 0 ) {
+			Log::Warning << "Vertex layout does not provide attribute " << location->getName() << Log::End;
+			valid = false;
+		}
+	};
+
+	check( ShaderProgram::StandardLocation::POSITION_ATTRIBUTE, ShaderProgramCatalog::AttributeSlot::POSITION );
+	check( ShaderProgram::StandardLocation::NORMAL_ATTRIBUTE, ShaderProgramCatalog::AttributeSlot::NORMAL );
+	check( ShaderProgram::StandardLocation::COLOR_ATTRIBUTE, ShaderProgramCatalog::AttributeSlot::COLOR );
+	check( ShaderProgram::StandardLocation::TEXTURE_COORD_ATTRIBUTE, ShaderProgramCatalog::AttributeSlot::TEXTURE_COORD );
+
+	return valid;
+}
+
+unsigned int GL3::VertexLayoutUtils::getSlotMask( const VertexFormat &format )
+{
+	unsigned int mask = 0;
+
+	if ( format.hasPositions() ) {
+		mask |= 1 << ShaderProgramCatalog::AttributeSlot::POSITION;
+	}
+
+	if ( format.hasNormals() ) {
+		mask |= 1 << ShaderProgramCatalog::AttributeSlot::NORMAL;
+	}
+
+	if ( format.hasColors() ) {
+		mask |= 1 << ShaderProgramCatalog::AttributeSlot::COLOR;
+	}
+
+	if ( format.hasTextureCoords() ) {
+		mask |= 1 << ShaderProgramCatalog::AttributeSlot::TEXTURE_COORD;
+	}
+
+	return mask;
+}
+
+bool GL3::VertexLayoutUtils::matchesAttribute( const PackedVertexLayout &layout, unsigned int slot, unsigned int components, unsigned int offset )
+{
+	const VertexFormat &format = layout.getVertexFormat();
+
+	switch ( slot ) {
+		case ShaderProgramCatalog::AttributeSlot::POSITION:
+			return format.getPositionComponents() == components && layout.getPositionsOffset() == offset;
+
+		case ShaderProgramCatalog::AttributeSlot::NORMAL:
+			return format.getNormalComponents() == components && layout.getNormalsOffset() == offset;
+
+		case ShaderProgramCatalog::AttributeSlot::COLOR:
+			return format.getColorComponents() == components && layout.getColorsOffset() == offset;
+
+		case ShaderProgramCatalog::AttributeSlot::TEXTURE_COORD:
+			return format.getTextureCoordComponents() == components && layout.getTextureCoordsOffset() == offset;
+
+		default:
+			return false;
+	}
+}
+
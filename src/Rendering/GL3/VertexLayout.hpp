@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRIMILD_GL3_VERTEX_LAYOUT_
+#define CRIMILD_GL3_VERTEX_LAYOUT_
+
+#include "PackedVertexLayout.hpp"
+#include "ShaderProgramCatalog.hpp"
+
+#include <Crimild.hpp>
+
+namespace Crimild {
+
+	namespace GL3 {
+
+		/**
+			\brief Storage type of a vertex attribute
+		*/
+		class VertexAttributeFormat {
+		public:
+			enum {
+				FLOAT,
+				HALF_FLOAT,
+				PACKED_INT_2_10_10_10,
+				NORMALIZED_UNSIGNED_SHORT,
+				NORMALIZED_UNSIGNED_BYTE
+			};
+		};
+
+		/**
+			\brief Describes a single attribute of a VertexLayout
+
+			SIZE is the number of bytes used in each vertex, padded to 
+			a multiple of four. PACKING is the PackedVertexLayout option 
+			producing the same storage, if any.
+		*/
+		template< unsigned int SLOT_, unsigned int COMPONENTS_, unsigned int FORMAT_, unsigned int SIZE_, unsigned int PACKING_ >
+		struct VertexAttribute {
+			static const unsigned int SLOT = SLOT_;
+			static const unsigned int COMPONENTS = COMPONENTS_;
+			static const unsigned int FORMAT = FORMAT_;
+			static const unsigned int SIZE = SIZE_;
+			static const unsigned int PACKING = PACKING_;
+
+			static_assert( SIZE % 4 == 0, "Vertex attributes must be word aligned" );
+		};
+
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::POSITION, 3, VertexAttributeFormat::FLOAT, 12, PackedVertexLayout::Packing::NONE > Position3f;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::POSITION, 3, VertexAttributeFormat::HALF_FLOAT, 8, PackedVertexLayout::Packing::HALF_POSITIONS > HalfPosition3;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::NORMAL, 3, VertexAttributeFormat::FLOAT, 12, PackedVertexLayout::Packing::NONE > Normal3f;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::NORMAL, 3, VertexAttributeFormat::PACKED_INT_2_10_10_10, 4, PackedVertexLayout::Packing::PACKED_NORMALS > PackedNormal3;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::COLOR, 4, VertexAttributeFormat::FLOAT, 16, PackedVertexLayout::Packing::NONE > Color4f;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::COLOR, 4, VertexAttributeFormat::NORMALIZED_UNSIGNED_BYTE, 4, PackedVertexLayout::Packing::NORMALIZED_COLORS > NormalizedColor4;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::TEXTURE_COORD, 2, VertexAttributeFormat::FLOAT, 8, PackedVertexLayout::Packing::NONE > UV2f;
+		typedef VertexAttribute< ShaderProgramCatalog::AttributeSlot::TEXTURE_COORD, 2, VertexAttributeFormat::NORMALIZED_UNSIGNED_SHORT, 4, PackedVertexLayout::Packing::NORMALIZED_TEXTURE_COORDS > NormalizedUV2;
+
+		/**
+			\brief Non-template helpers used by VertexLayout
+		*/
+		class VertexLayoutUtils {
+		public:
+			/**
+				\brief Enables an attribute in the bound vertex array
+
+				Slots are translated with the program attribute signature, 
+				and attributes the program lacks are skipped.
+			*/
+			static void setAttributePointer( unsigned int signature, unsigned int slot, unsigned int components, unsigned int format, unsigned int stride, unsigned int offset );
+
+			/**
+				\brief Checks that every standard attribute read by a program is in slotMask
+			*/
+			static bool validate( ShaderProgram *program, unsigned int slotMask );
+
+			/**
+				\brief Standard slots present in a runtime vertex format
+			*/
+			static unsigned int getSlotMask( const VertexFormat &format );
+
+			/**
+				\brief Checks if an attribute is stored at the same place in a runtime layout
+			*/
+			static bool matchesAttribute( const PackedVertexLayout &layout, unsigned int slot, unsigned int components, unsigned int offset );
+		};
+
+		/**
+			\brief Vertex layout described at compile time
+
+			Attributes are stored in declaration order:
+
+			\code
+			typedef VertexLayout< Position3f, Normal3f, UV2f > MeshLayout;
+			MeshLayout::configureAttributes( signature, byteOffset );
+			\endcode
+
+			Stride and offsets are compile time constants, attribute 
+			pointer setup is unrolled, and declaring the same slot twice 
+			fails to compile.
+		*/
+		template< typename... Attributes >
+		class VertexLayout;
+
+		template<>
+		class VertexLayout<> {
+		public:
+			static const unsigned int STRIDE = 0;
+			static const unsigned int SLOT_MASK = 0;
+			static const unsigned int PACKING = 0;
+
+			template< unsigned int SLOT >
+			struct Offset {
+				static const int VALUE = -1;
+			};
+
+			static void configureAttributes( unsigned int, unsigned int, unsigned int, unsigned int ) { }
+			static bool matchesAttributes( const PackedVertexLayout &, unsigned int ) { return true; }
+		};
+
+		template< typename First, typename... Rest >
+		class VertexLayout< First, Rest... > {
+		private:
+			typedef VertexLayout< Rest... > Tail;
+
+			static_assert( ( Tail::SLOT_MASK & ( 1 << First::SLOT ) ) == 0, "Vertex attribute slot declared twice" );
+
+		public:
+			static const unsigned int STRIDE = First::SIZE + Tail::STRIDE;
+			static const unsigned int SLOT_MASK = ( 1 << First::SLOT ) | Tail::SLOT_MASK;
+			static const unsigned int PACKING = First::PACKING | Tail::PACKING;
+
+			/**
+				\brief Byte offset of the attribute at SLOT, or -1 if missing
+			*/
+			template< unsigned int SLOT >
+			struct Offset {
+				static const int VALUE = ( SLOT == First::SLOT ) ? 0 
+					: ( Tail::template Offset< SLOT >::VALUE < 0 ? -1 : ( int ) First::SIZE + Tail::template Offset< SLOT >::VALUE );
+			};
+
+			/**
+				\brief Sets up attribute pointers for the bound vertex array
+			*/
+			static void configureAttributes( unsigned int signature = 0, unsigned int byteOffset = 0 )
+			{
+				configureAttributes( signature, STRIDE, byteOffset, 0 );
+			}
+
+			static void configureAttributes( unsigned int signature, unsigned int stride, unsigned int byteOffset, unsigned int attributeOffset )
+			{
+				VertexLayoutUtils::setAttributePointer( signature, First::SLOT, First::COMPONENTS, First::FORMAT, stride, byteOffset + attributeOffset );
+				Tail::configureAttributes( signature, stride, byteOffset, attributeOffset + First::SIZE );
+			}
+
+			/**
+				\brief Checks that the program reads no attribute missing from this layout
+			*/
+			static bool validate( ShaderProgram *program )
+			{
+				return VertexLayoutUtils::validate( program, SLOT_MASK );
+			}
+
+			/**
+				\brief Checks if a runtime layout stores vertices exactly like this one
+
+				Lets code driven by a VertexFormat use the generated setup
+			*/
+			static bool matches( const PackedVertexLayout &layout )
+			{
+				return layout.getStride() == STRIDE 
+					&& layout.getPacking() == PACKING 
+					&& VertexLayoutUtils::getSlotMask( layout.getVertexFormat() ) == SLOT_MASK
+					&& matchesAttributes( layout, 0 );
+			}
+
+			static bool matchesAttributes( const PackedVertexLayout &layout, unsigned int attributeOffset )
+			{
+				return VertexLayoutUtils::matchesAttribute( layout, First::SLOT, First::COMPONENTS, attributeOffset )
+					&& Tail::matchesAttributes( layout, attributeOffset + First::SIZE );
+			}
+		};
+
+	}
+
+}
+
+#endif
+
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Crimild.hpp>
+#include <CrimildGL.hpp>
+
+#include <GL/glew.h>
+#include <GL/glfw.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace Crimild;
+
+namespace {
+
+	const unsigned int CAPACITY = 1024;
+	const unsigned int BLOCK_SIZE = 60;
+	const unsigned int BLOCK_ALIGNMENT = 16;
+	const int BLOCK_COUNT = 12;
+
+	// reported by CTest as a skipped test
+	const int SKIPPED = 77;
+
+	bool fail( const char *description )
+	{
+		std::cout << "FAILED: " << description << std::endl;
+		return false;
+	}
+
+	bool testAllocateAndRelease( void )
+	{
+		GL3::BufferPool pool( CAPACITY );
+
+		std::map< int, unsigned int > offsets;
+		for ( int owner = 1; owner <= BLOCK_COUNT; owner++ ) {
+			unsigned int offset;
+			if ( !pool.allocate( BLOCK_SIZE, BLOCK_ALIGNMENT, owner, offset ) ) {
+				return fail( "block could not be allocated" );
+			}
+			if ( offset % BLOCK_ALIGNMENT != 0 || offset + BLOCK_SIZE > CAPACITY ) {
+				return fail( "block is misaligned or out of bounds" );
+			}
+			for ( auto &it : offsets ) {
+				if ( offset < it.second + BLOCK_SIZE && it.second < offset + BLOCK_SIZE ) {
+					return fail( "blocks overlap" );
+				}
+			}
+			offsets[ owner ] = offset;
+		}
+
+		if ( pool.getUsedSize() != BLOCK_COUNT * BLOCK_SIZE ) {
+			return fail( "used size does not match allocated blocks" );
+		}
+
+		unsigned int offset;
+		if ( pool.allocate( CAPACITY, 1, BLOCK_COUNT + 1, offset ) ) {
+			return fail( "allocated more than the free space" );
+		}
+
+		for ( int owner = 1; owner <= BLOCK_COUNT; owner += 2 ) {
+			pool.release( offsets[ owner ] );
+		}
+		for ( int owner = 2; owner <= BLOCK_COUNT; owner += 2 ) {
+			pool.release( offsets[ owner ] );
+		}
+
+		// released neighbours are merged back into a single block
+		if ( pool.getUsedSize() != 0 || pool.getFreeBlockCount() != 1 ) {
+			return fail( "released blocks were not merged back" );
+		}
+
+		if ( !pool.allocate( CAPACITY, 1, 1, offset ) || offset != 0 ) {
+			return fail( "whole capacity is not available after releasing everything" );
+		}
+
+		return true;
+	}
+
+	bool testDefragment( void )
+	{
+		GL3::BufferPool pool( CAPACITY );
+
+		std::map< int, unsigned int > offsets;
+		for ( int owner = 1; owner <= BLOCK_COUNT; owner++ ) {
+			unsigned int offset;
+			if ( !pool.allocate( BLOCK_SIZE, BLOCK_ALIGNMENT, owner, offset ) ) {
+				return fail( "block could not be allocated" );
+			}
+			std::vector< unsigned char > data( BLOCK_SIZE, ( unsigned char ) owner );
+			pool.upload( offset, &data[ 0 ], BLOCK_SIZE );
+			offsets[ owner ] = offset;
+		}
+
+		for ( int owner = 1; owner <= BLOCK_COUNT; owner += 2 ) {
+			pool.release( offsets[ owner ] );
+			offsets.erase( owner );
+		}
+
+		unsigned int usedSize = pool.getUsedSize();
+
+		std::map< int, unsigned int > relocated;
+		pool.defragment( [&]( int owner, unsigned int offset ) {
+			relocated[ owner ] = offset;
+		});
+
+		if ( relocated.size() != offsets.size() ) {
+			return fail( "not every live block was reported" );
+		}
+
+		if ( pool.getUsedSize() != usedSize || pool.getFreeBlockCount() != 1 ) {
+			return fail( "free space is still fragmented" );
+		}
+
+		std::vector< unsigned char > contents( CAPACITY );
+		glBindBuffer( GL_COPY_READ_BUFFER, pool.getBufferId() );
+		glGetBufferSubData( GL_COPY_READ_BUFFER, 0, CAPACITY, &contents[ 0 ] );
+
+		for ( auto &it : relocated ) {
+			if ( offsets.find( it.first ) == offsets.end() ) {
+				return fail( "a released block was relocated" );
+			}
+			if ( it.second % BLOCK_ALIGNMENT != 0 ) {
+				return fail( "relocated block lost its alignment" );
+			}
+			for ( unsigned int i = 0; i < BLOCK_SIZE; i++ ) {
+				if ( contents[ it.second + i ] != ( unsigned char ) it.first ) {
+					return fail( "block contents were not moved along with it" );
+				}
+			}
+		}
+
+		// everything left after the last block is free again
+		unsigned int offset;
+		unsigned int end = 0;
+		for ( auto &it : relocated ) {
+			end = std::max( end, it.second + BLOCK_SIZE );
+		}
+		if ( !pool.allocate( CAPACITY - end, 1, BLOCK_COUNT + 1, offset ) || offset != end ) {
+			return fail( "free space was not packed after the live blocks" );
+		}
+
+		pool.unload();
+		return true;
+	}
+
+	bool createContext( void )
+	{
+		if ( !glfwInit() ) {
+			return false;
+		}
+
+		glfwOpenWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+		glfwOpenWindowHint( GLFW_OPENGL_VERSION_MAJOR, 3 );
+		glfwOpenWindowHint( GLFW_OPENGL_VERSION_MINOR, 2 );
+		if ( !glfwOpenWindow( 64, 64, 8, 8, 8, 8, 0, 0, GLFW_WINDOW ) ) {
+			glfwTerminate();
+			return false;
+		}
+
+		glewExperimental = GL_TRUE;
+		return glewInit() == GLEW_OK && GLEW_VERSION_3_2;
+	}
+
+}
+
+int main( int argc, char **argv )
+{
+	if ( !testAllocateAndRelease() ) {
+		return 1;
+	}
+
+	// moving blocks around needs real buffers
+	if ( !createContext() ) {
+		std::cout << "No OpenGL 3.2 context available, defragmentation was not tested" << std::endl;
+		return SKIPPED;
+	}
+
+	bool passed = testDefragment();
+	glfwTerminate();
+
+	return passed ? 0 : 1;
+}
+
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Rendering/GL3/DirtyRangeSet.hpp>
+
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using namespace Crimild;
+
+namespace {
+
+	typedef std::vector< std::pair< unsigned int, unsigned int > > RangeArray;
+
+	RangeArray getRanges( const GL3::DirtyRangeSet &set )
+	{
+		RangeArray ranges;
+		set.foreachRange( [&]( unsigned int begin, unsigned int end ) {
+			ranges.push_back( std::make_pair( begin, end ) );
+		});
+		return ranges;
+	}
+
+	bool expectRanges( const GL3::DirtyRangeSet &set, const RangeArray &expected, const char *description )
+	{
+		RangeArray ranges = getRanges( set );
+		if ( ranges == expected ) {
+			return true;
+		}
+
+		std::cout << "FAILED: " << description << ", got";
+		for ( auto &range : ranges ) {
+			std::cout << " [" << range.first << ", " << range.second << ")";
+		}
+		std::cout << std::endl;
+		return false;
+	}
+
+}
+
+int main( int argc, char **argv )
+{
+	bool passed = true;
+
+	GL3::DirtyRangeSet set;
+	set.insert( 0, 4 );
+	set.insert( 4, 8 );
+	passed &= expectRanges( set, { { 0, 8 } }, "adjacent ranges are merged" );
+
+	set.insert( 10, 12 );
+	passed &= expectRanges( set, { { 0, 8 }, { 10, 12 } }, "disjoint ranges are kept apart" );
+
+	set.insert( 6, 11 );
+	passed &= expectRanges( set, { { 0, 12 } }, "a range bridging two others merges all three" );
+
+	set.insert( 20, 20 );
+	passed &= expectRanges( set, { { 0, 12 } }, "empty ranges are ignored" );
+
+	if ( set.getCoveredSize() != 12 ) {
+		std::cout << "FAILED: covered size is " << set.getCoveredSize() << " instead of 12" << std::endl;
+		passed = false;
+	}
+
+	GL3::DirtyRangeSet limited( 2 );
+	limited.insert( 0, 1 );
+	limited.insert( 10, 11 );
+	limited.insert( 12, 13 );
+	passed &= expectRanges( limited, { { 0, 1 }, { 10, 13 } }, "the closest ranges are merged once over the limit" );
+
+	limited.clear();
+	passed &= expectRanges( limited, {}, "clearing removes every range" );
+
+	return passed ? 0 : 1;
+}
+
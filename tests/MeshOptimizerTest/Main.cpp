@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Crimild.hpp>
+#include <CrimildGL.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace Crimild;
+
+namespace {
+
+	const unsigned int GRID_SIZE = 16;
+
+	// a grid whose triangles are drawn in random order, the worst case for the vertex cache
+	PrimitivePtr createShuffledGrid( void )
+	{
+		std::vector< float > vertices;
+		for ( unsigned int y = 0; y <= GRID_SIZE; y++ ) {
+			for ( unsigned int x = 0; x <= GRID_SIZE; x++ ) {
+				vertices.push_back( x );
+				vertices.push_back( y );
+				vertices.push_back( 0.0f );
+			}
+		}
+
+		std::vector< unsigned int > quads( GRID_SIZE * GRID_SIZE );
+		for ( unsigned int i = 0; i < quads.size(); i++ ) {
+			quads[ i ] = i;
+		}
+		std::shuffle( quads.begin(), quads.end(), std::mt19937( 1234 ) );
+
+		std::vector< unsigned short > indices;
+		for ( auto quad : quads ) {
+			unsigned short v0 = ( quad / GRID_SIZE ) * ( GRID_SIZE + 1 ) + quad % GRID_SIZE;
+			unsigned short v1 = v0 + 1;
+			unsigned short v2 = v0 + GRID_SIZE + 1;
+			unsigned short v3 = v2 + 1;
+			indices.push_back( v0 ); indices.push_back( v1 ); indices.push_back( v3 );
+			indices.push_back( v0 ); indices.push_back( v3 ); indices.push_back( v2 );
+		}
+
+		PrimitivePtr primitive( new Primitive( Primitive::Type::TRIANGLES ) );
+		primitive->setVertexBuffer( VertexBufferObjectPtr( new VertexBufferObject( VertexFormat( 3, 0, 0, 0 ), vertices.size() / 3, &vertices[ 0 ] ) ) );
+		primitive->setIndexBuffer( IndexBufferObjectPtr( new IndexBufferObject( indices.size(), &indices[ 0 ] ) ) );
+		return primitive;
+	}
+
+	float computeACMR( Primitive *primitive )
+	{
+		IndexBufferObject *ibo = primitive->getIndexBuffer();
+		return GL3::MeshOptimizer::computeACMR( ibo->getData(), ibo->getIndexCount() );
+	}
+
+}
+
+int main( int argc, char **argv )
+{
+	PrimitivePtr primitive = createShuffledGrid();
+	float acmrBefore = computeACMR( primitive.get() );
+	unsigned int triangleCount = primitive->getIndexBuffer()->getIndexCount() / 3;
+
+	GL3::MeshOptimizer optimizer;
+	if ( !optimizer.optimize( primitive.get() ) ) {
+		std::cout << "FAILED: grid was not optimized" << std::endl;
+		return 1;
+	}
+
+	if ( primitive->getIndexBuffer()->getIndexCount() / 3 != triangleCount ) {
+		std::cout << "FAILED: optimizing changed the triangle count" << std::endl;
+		return 1;
+	}
+
+	float acmrAfter = computeACMR( primitive.get() );
+	if ( acmrAfter > acmrBefore ) {
+		std::cout << "FAILED: ACMR went from " << acmrBefore << " to " << acmrAfter << std::endl;
+		return 1;
+	}
+
+	// an already optimized mesh must not get any worse
+	float acmrOptimized = acmrAfter;
+	optimizer.optimize( primitive.get() );
+	acmrAfter = computeACMR( primitive.get() );
+	if ( acmrAfter > acmrOptimized ) {
+		std::cout << "FAILED: optimizing twice raised ACMR from " << acmrOptimized << " to " << acmrAfter << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Crimild.hpp>
+#include <CrimildGL.hpp>
+
+#include <iostream>
+
+using namespace Crimild;
+
+namespace {
+
+	const float EPSILON = 0.0001f;
+
+	float VERTICES[] = {
+		-1.0f, -1.0f, 0.0f,
+		1.0f, -1.0f, 0.0f,
+		0.0f, 1.0f, 0.0f
+	};
+
+	bool isClose( const Vector3f &a, const Vector3f &b )
+	{
+		return ( a - b ).getSquaredMagnitude() < EPSILON;
+	}
+
+	void print( const Vector3f &v )
+	{
+		std::cout << "(" << v[ 0 ] << ", " << v[ 1 ] << ", " << v[ 2 ] << ")";
+	}
+
+	GeometryPtr createTriangle( MaterialPtr material )
+	{
+		unsigned short indices[] = {
+			0, 1, 2
+		};
+
+		PrimitivePtr primitive( new Primitive( Primitive::Type::TRIANGLES ) );
+		primitive->setVertexBuffer( VertexBufferObjectPtr( new VertexBufferObject( VertexFormat( 3, 0, 0, 0 ), 3, VERTICES ) ) );
+		primitive->setIndexBuffer( IndexBufferObjectPtr( new IndexBufferObject( 3, indices ) ) );
+
+		GeometryPtr geometry( new Geometry() );
+		geometry->attachPrimitive( primitive );
+		geometry->getComponent< MaterialComponent >()->attachMaterial( material );
+		return geometry;
+	}
+
+}
+
+int main( int argc, char **argv )
+{
+	MaterialPtr material( new Material() );
+
+	// both the batched root and its parent are moved, so baking 
+	// in world space would apply their transforms twice
+	GroupPtr scene( new Group() );
+	scene->local().setTranslate( 0.0f, 0.0f, -20.0f );
+
+	GroupPtr root( new Group() );
+	root->local().setTranslate( 10.0f, 0.0f, 0.0f );
+	scene->attachNode( root );
+
+	GeometryPtr prop = createTriangle( material );
+	prop->local().setTranslate( 0.0f, 5.0f, 0.0f );
+	root->attachNode( prop );
+
+	scene->perform( UpdateWorldState() );
+	Vector3f expected[ 3 ];
+	for ( unsigned int i = 0; i < 3; i++ ) {
+		prop->getWorld().applyToPoint( Vector3f( VERTICES[ i * 3 ], VERTICES[ i * 3 + 1 ], VERTICES[ i * 3 + 2 ] ), expected[ i ] );
+	}
+
+	GL3::StaticBatcher batcher;
+	GroupPtr batches = batcher.batch( root );
+	scene->perform( UpdateWorldState() );
+
+	Geometry *batch = nullptr;
+	unsigned int batchCount = 0;
+	batches->foreachNode( [&]( NodePtr &node ) {
+		batch = dynamic_cast< Geometry * >( node.get() );
+		++batchCount;
+	});
+
+	if ( batchCount != 1 || batch == nullptr ) {
+		std::cout << "FAILED: expected a single batch, got " << batchCount << std::endl;
+		return 1;
+	}
+
+	bool passed = true;
+	batch->foreachPrimitive( [&]( PrimitivePtr &primitive ) {
+		const float *vertices = primitive->getVertexBuffer()->getData();
+		for ( unsigned int i = 0; i < 3; i++ ) {
+			Vector3f position;
+			batch->getWorld().applyToPoint( Vector3f( vertices[ i * 3 ], vertices[ i * 3 + 1 ], vertices[ i * 3 + 2 ] ), position );
+			if ( !isClose( position, expected[ i ] ) ) {
+				std::cout << "FAILED: vertex " << i << " is drawn at ";
+				print( position );
+				std::cout << " instead of ";
+				print( expected[ i ] );
+				std::cout << std::endl;
+				passed = false;
+			}
+		}
+	});
+
+	GL3::StaticBatchComponent *component = batch->getComponent< GL3::StaticBatchComponent >();
+	if ( component == nullptr ) {
+		std::cout << "FAILED: batch has no StaticBatchComponent" << std::endl;
+		return 1;
+	}
+
+	Vector3f center;
+	batch->getWorld().applyToPoint( component->getBound().getCenter(), center );
+	Vector3f expectedCenter = ( expected[ 0 ] + expected[ 1 ] + expected[ 2 ] ) * ( 1.0f / 3.0f );
+	if ( !isClose( center, expectedCenter ) ) {
+		std::cout << "FAILED: bound is centered at ";
+		print( center );
+		std::cout << " instead of ";
+		print( expectedCenter );
+		std::cout << std::endl;
+		passed = false;
+	}
+
+	return passed ? 0 : 1;
+}
+
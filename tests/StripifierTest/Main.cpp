@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <Crimild.hpp>
+#include <CrimildGL.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+using namespace Crimild;
+
+namespace {
+
+	struct Triangle {
+		unsigned short a, b, c;
+
+		bool operator<( const Triangle &other ) const
+		{
+			return a != other.a ? a < other.a : ( b != other.b ? b < other.b : c < other.c );
+		}
+
+		bool operator==( const Triangle &other ) const
+		{
+			return a == other.a && b == other.b && c == other.c;
+		}
+	};
+
+	// rotates the smallest index first, which keeps the winding
+	Triangle makeTriangle( unsigned short a, unsigned short b, unsigned short c )
+	{
+		Triangle t;
+		if ( a < b && a < c ) {
+			t.a = a; t.b = b; t.c = c;
+		}
+		else if ( b < c ) {
+			t.a = b; t.b = c; t.c = a;
+		}
+		else {
+			t.a = c; t.b = a; t.c = b;
+		}
+		return t;
+	}
+
+	// expands restart-separated strips, flipping every other triangle like GL does
+	std::vector< Triangle > expandStrips( const std::vector< unsigned short > &strips )
+	{
+		std::vector< Triangle > triangles;
+		unsigned int start = 0;
+		for ( unsigned int i = 0; i <= strips.size(); i++ ) {
+			if ( i < strips.size() && strips[ i ] != GL3::Stripifier::RESTART_INDEX ) {
+				continue;
+			}
+
+			for ( unsigned int k = start; k + 2 < i; k++ ) {
+				unsigned short a = strips[ k ];
+				unsigned short b = strips[ k + 1 ];
+				unsigned short c = strips[ k + 2 ];
+				if ( a == b || b == c || a == c ) {
+					continue;
+				}
+
+				triangles.push_back( ( k - start ) % 2 == 0 ? makeTriangle( a, b, c ) : makeTriangle( b, a, c ) );
+			}
+
+			start = i + 1;
+		}
+
+		std::sort( triangles.begin(), triangles.end() );
+		return triangles;
+	}
+
+	// counter-clockwise triangles covering a grid of quads
+	std::vector< unsigned short > createGrid( unsigned int width, unsigned int height )
+	{
+		std::vector< unsigned short > indices;
+		for ( unsigned int y = 0; y < height; y++ ) {
+			for ( unsigned int x = 0; x < width; x++ ) {
+				unsigned short v0 = y * ( width + 1 ) + x;
+				unsigned short v1 = v0 + 1;
+				unsigned short v2 = v0 + width + 1;
+				unsigned short v3 = v2 + 1;
+				indices.push_back( v0 ); indices.push_back( v1 ); indices.push_back( v3 );
+				indices.push_back( v0 ); indices.push_back( v3 ); indices.push_back( v2 );
+			}
+		}
+		return indices;
+	}
+
+}
+
+int main( int argc, char **argv )
+{
+	std::vector< unsigned short > indices = createGrid( 8, 8 );
+
+	std::vector< unsigned short > strips;
+	if ( !GL3::Stripifier::stripify( &indices[ 0 ], indices.size(), strips ) ) {
+		std::cout << "FAILED: grid could not be converted to strips" << std::endl;
+		return 1;
+	}
+
+	std::vector< Triangle > expected;
+	for ( unsigned int i = 0; i < indices.size(); i += 3 ) {
+		expected.push_back( makeTriangle( indices[ i ], indices[ i + 1 ], indices[ i + 2 ] ) );
+	}
+	std::sort( expected.begin(), expected.end() );
+
+	if ( expandStrips( strips ) != expected ) {
+		std::cout << "FAILED: strips do not reproduce the original triangles with their winding" << std::endl;
+		return 1;
+	}
+
+	if ( strips.size() >= indices.size() ) {
+		std::cout << "FAILED: strips use " << strips.size() << " indices, the list only " << indices.size() << std::endl;
+		return 1;
+	}
+
+	std::vector< unsigned short > reserved = { 0, 1, GL3::Stripifier::RESTART_INDEX };
+	if ( GL3::Stripifier::stripify( &reserved[ 0 ], reserved.size(), strips ) ) {
+		std::cout << "FAILED: triangles using the restart index were converted" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
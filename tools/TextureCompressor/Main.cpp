@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2013, Hernan Saez
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the <organization> nor the
+ *       names of its contributors may be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Crimild.hpp>
+#include <CrimildGL.hpp>
+
+#include <iostream>
+
+using namespace Crimild;
+
+int main( int argc, char **argv )
+{
+	if ( argc < 3 ) {
+		std::cout << "Usage: TextureCompressor input.tga output.(ktx|dds) [--no-mipmaps]" << std::endl;
+		return 1;
+	}
+
+	std::string input = argv[ 1 ];
+	std::string output = argv[ 2 ];
+	bool mipmaps = !( argc > 3 && std::string( argv[ 3 ] ) == "--no-mipmaps" );
+
+	ImagePtr image( new ImageTGA( input ) );
+	if ( image->getData() == nullptr || ( image->getBpp() != 3 && image->getBpp() != 4 ) ) {
+		Log::Error << "Cannot read " << input << Log::End;
+		return 1;
+	}
+
+	GL3::CompressedImagePtr compressed = GL3::BlockCompressor::compress( image->getWidth(), image->getHeight(), image->getBpp(), image->getData(), mipmaps );
+	if ( !compressed->save( output ) ) {
+		Log::Error << "Cannot write " << output << Log::End;
+		return 1;
+	}
+
+	std::cout << input << " -> " << output << " (" << compressed->getLevelCount() << " levels, " 
+			  << compressed->getTotalSize() << " bytes)" << std::endl;
+
+	return 0;
+}
+